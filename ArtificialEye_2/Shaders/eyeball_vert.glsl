@@ -1,7 +1,7 @@
 #version 330 core
 
 layout(location = 0) in vec3 l_position;
-layout(location = 1) in vec3 l_normal;
+layout(location = 1) in vec2 l_normal; // octahedral encoded
 layout(location = 2) in vec2 l_textCoord;
 
 out vec2 p_textCoord;
@@ -1,7 +1,7 @@
 #version 330 core
 
 layout(location = 0) in vec3 l_position;
-layout(location = 1) in vec3 l_normals;
+layout(location = 1) in vec2 l_normals; // octahedral encoded
 layout(location = 2) in vec2 l_textCoord;
 
 uniform mat4 u_posTrans;
@@ -11,9 +11,20 @@ uniform mat4 u_model;
 out vec3 p_normal;
 out vec3 p_fragPosition;
 
+// the inverse of ee::encodeOctNormal
+vec3 decodeOctNormal(vec2 e)
+{
+    vec3 v = vec3(e, 1.f - abs(e.x) - abs(e.y));
+    if (v.z < 0.f)
+    {
+        v.xy = (1.f - abs(v.yx)) * vec2(v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f);
+    }
+    return normalize(v);
+}
+
 void main()
 {
     gl_Position = u_posTrans * vec4(l_position, 1.f);
     p_fragPosition = vec3(u_model * vec4(l_position, 1.f));
-    p_normal = mat3(transpose(inverse(u_model))) * l_normals;
+    p_normal = mat3(transpose(inverse(u_model))) * decodeOctNormal(l_normals);
 }
\ No newline at end of file
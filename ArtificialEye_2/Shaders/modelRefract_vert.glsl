@@ -4,7 +4,7 @@
 // Per-face refraction using the default drawable shader interface
 
 layout (location = 0) in vec3 l_position;
-layout (location = 1) in vec3 l_normals;
+layout (location = 1) in vec2 l_normals; // octahedral encoded
 layout (location = 2) in vec2 l_textCoord;
 
 uniform mat4 u_posTrans;
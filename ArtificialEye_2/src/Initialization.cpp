@@ -97,6 +97,8 @@ ee::ArtificialEyeProp ee::initializeArtificialEyeProp(const std::string& dir)
         result.render_param.m_near =            getFloat("graphics", "near_plane",       dir);
         result.render_param.m_aspect = static_cast<float>(result.render_param.m_screenWidth) / result.render_param.m_screenHeight;
 
+        result.mesh_type =                      getUInt ("lens",     "mesh_type",        dir);
+        result.icosphere_level =                getUInt ("lens",     "icosphere_level",  dir);
         result.latitude =                       getUInt ("lens",     "latitude",         dir);
         result.longitude =                      getUInt ("lens",     "longitude",        dir);
         result.iterations =                     getUInt ("lens",     "iterations",       dir);
@@ -105,12 +107,35 @@ ee::ArtificialEyeProp ee::initializeArtificialEyeProp(const std::string& dir)
         result.intspring_drag =                 getFloat("lens",     "intspring_drag",   dir);
         result.extspring_coeff =                getFloat("lens",     "extspring_coeff",  dir);
         result.extspring_drag =                 getFloat("lens",     "extspring_drag",   dir);
+        result.interior_model =                 getUInt ("lens",     "interior_model",   dir);
+        result.shape_match_stiffness =          getFloat("lens",     "shape_match_stiffness", dir);
+        result.shape_match_radius =             getUInt ("lens",     "shape_match_radius", dir);
         result.pressure =                       getFloat("lens",     "pressure",         dir);
+        result.volume_constraint =              getUInt ("lens",     "volume_constraint", dir) == 1;
         result.muscle_thickness =               getUInt ("lens",     "muscle_thickness", dir);
         result.refractive_index =               getFloat("lens",     "refractive_index", dir);
         result.lens_thickness =                 getFloat("lens",     "lens_thickness",   dir);
         result.subdiv_level_lens =              getUInt ("lens",     "subdiv_level",     dir);
+        result.adaptive_subdiv =                getUInt ("lens",     "adaptive_subdiv",  dir) == 1;
+        result.adaptive_axis_radius =           getFloat("lens",     "adaptive_axis_radius", dir);
+        result.adaptive_curvature_angle =       getFloat("lens",     "adaptive_curvature_angle", dir);
+        result.limit_surface_optics =           getUInt ("lens",     "limit_surface_optics", dir) == 1;
+        result.gradient_index =                 getUInt ("lens",     "gradient_index",   dir) == 1;
         result.subdiv_level_cornea =            getUInt ("cornea",   "subdiv_level",     dir);
+
+        result.spot_rays =                      getUInt ("retina",   "spot_rays",        dir);
+        result.pupil_radius =                   getFloat("retina",   "pupil_radius",     dir);
+        result.retina_z =                       getFloat("retina",   "retina_z",         dir);
+        result.psf_resolution =                 getUInt ("retina",   "psf_resolution",   dir);
+        result.psf_half_width =                 getFloat("retina",   "psf_half_width",   dir);
+        result.analyze_every_update =           getUInt ("retina",   "analyze_every_update", dir) == 1;
+
+        result.fan_rays =                       getUInt ("paraxial", "fan_rays",         dir);
+        result.fan_height =                     getFloat("paraxial", "fan_height",       dir);
+        result.mm_per_unit =                    getFloat("paraxial", "mm_per_unit",      dir);
+
+        result.record_trajectory =              getUInt ("recording", "record_trajectory", dir) == 1;
+        result.trajectory_file =                getStr  ("recording", "trajectory_file",   dir);
     }
     catch (const std::exception& e)
     {
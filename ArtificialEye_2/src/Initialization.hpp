@@ -16,6 +16,8 @@ namespace ee
         std::string     shader_dir;
         RendererParam   render_param;
 
+        unsigned        mesh_type;
+        unsigned        icosphere_level;
         std::size_t     latitude;
         std::size_t     longitude;
         std::size_t     iterations;
@@ -26,13 +28,37 @@ namespace ee
         Float           extspring_coeff;
         Float           extspring_drag;
 
+        unsigned        interior_model;
+        Float           shape_match_stiffness;
+        unsigned        shape_match_radius;
+
         Float           pressure;
+        bool            volume_constraint;
         unsigned        muscle_thickness;
         Float           refractive_index;
         Float           lens_thickness;
 
         unsigned        subdiv_level_lens;
+        bool            adaptive_subdiv;
+        Float           adaptive_axis_radius;
+        Float           adaptive_curvature_angle;
+        bool            limit_surface_optics;
+        bool            gradient_index;
         unsigned        subdiv_level_cornea;
+
+        unsigned        spot_rays;
+        Float           pupil_radius;
+        Float           retina_z;
+        unsigned        psf_resolution;
+        Float           psf_half_width;
+        bool            analyze_every_update;
+
+        unsigned        fan_rays;
+        Float           fan_height;
+        Float           mm_per_unit;
+
+        bool            record_trajectory;
+        std::string     trajectory_file;
     };
 
     ArtificialEyeProp initializeArtificialEyeProp(const std::string& dir);
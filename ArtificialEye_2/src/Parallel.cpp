@@ -0,0 +1,147 @@
+#include "Parallel.hpp"
+
+#include <memory>
+
+// VS2013 has no thread_local yet
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define EE_THREAD_LOCAL __declspec(thread)
+#else
+#define EE_THREAD_LOCAL thread_local
+#endif
+
+namespace
+{
+    std::once_flag                      g_sharedPoolFlag;
+    std::unique_ptr<ee::WorkerPool>     g_sharedPool;
+
+    // set while this thread runs a task of a pool, nested runs go inline instead of taking the pool again
+    EE_THREAD_LOCAL bool                g_inPoolTask = false;
+}
+
+ee::WorkerPool::WorkerPool(const std::size_t numThreads) :
+    m_task(nullptr),
+    m_numTasks(0),
+    m_nextTask(0),
+    m_numFinished(0),
+    m_generation(0),
+    m_stopping(false)
+{
+    m_threads.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; i++)
+    {
+        m_threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+    }
+}
+
+ee::WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ee::WorkerPool::run(const std::size_t numTasks, const std::function<void(std::size_t)>& task)
+{
+    if (numTasks == 0)
+    {
+        return;
+    }
+
+    if (m_threads.empty() || numTasks == 1 || g_inPoolTask || !m_runMutex.try_lock())
+    {
+        for (std::size_t i = 0; i < numTasks; i++)
+        {
+            task(i);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> runLock(m_runMutex, std::adopt_lock);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_numTasks = numTasks;
+    m_nextTask = 0;
+    m_numFinished = 0;
+    m_error = nullptr;
+    const long long unsigned generation = ++m_generation;
+    m_wake.notify_all();
+
+    runTasks(lock, generation);
+    m_done.wait(lock, [this]() { return m_numFinished == m_numTasks; });
+    m_task = nullptr;
+
+    // every task is finished before the first exception goes on to the caller:
+    if (m_error)
+    {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+ee::WorkerPool& ee::WorkerPool::getShared()
+{
+    std::call_once(g_sharedPoolFlag, []()
+    {
+        g_sharedPool.reset(new WorkerPool(getNumWorkers() - 1));
+    });
+    return *g_sharedPool;
+}
+
+void ee::WorkerPool::workerLoop()
+{
+    long long unsigned seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this, seenGeneration]() { return m_stopping || m_generation != seenGeneration; });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        seenGeneration = m_generation;
+        runTasks(lock, seenGeneration);
+    }
+}
+
+void ee::WorkerPool::runTasks(std::unique_lock<std::mutex>& lock, const long long unsigned generation)
+{
+    // a thread that wakes up late must not take the tasks of the next run:
+    while (m_generation == generation && m_task && m_nextTask < m_numTasks)
+    {
+        const std::size_t taskID = m_nextTask++;
+        const std::function<void(std::size_t)>& task = *m_task;
+
+        lock.unlock();
+        std::exception_ptr error;
+        g_inPoolTask = true;
+        try
+        {
+            task(taskID);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        g_inPoolTask = false;
+        lock.lock();
+
+        if (error && !m_error)
+        {
+            m_error = error;
+        }
+
+        if (++m_numFinished == m_numTasks)
+        {
+            m_done.notify_all();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ee
+{
+    // Number of hardware threads that the parallel helpers will split work across
+    inline std::size_t getNumWorkers()
+    {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware == 0 ? 1 : hardware;
+    }
+
+    // Threads that are started once and wait for work, so the parallel helpers don't start threads on
+    // every call. run() hands out the tasks one at a time to the threads and the calling thread. If the
+    // pool is already busy (a nested parallel loop or a run from another thread) the caller runs all of
+    // the tasks itself, so runs never wait for each other. A run started from inside a task of the pool
+    // runs inline the same way. The first exception a task throws is rethrown by run() once every
+    // task is done.
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(std::size_t numThreads);
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool();
+
+        // calls task(i) for every i in [0, numTasks) and returns when all of them are done
+        void run(std::size_t numTasks, const std::function<void(std::size_t)>& task);
+
+        std::size_t getNumThreads() const { return m_threads.size(); }
+
+        // the pool the parallel helpers use, getNumWorkers() - 1 threads started on the first call
+        static WorkerPool& getShared();
+
+    private:
+        void workerLoop();
+        void runTasks(std::unique_lock<std::mutex>& lock, long long unsigned generation);
+
+        std::vector<std::thread>                    m_threads;
+        std::mutex                                  m_runMutex; // held for a whole run
+        std::mutex                                  m_mutex;
+        std::condition_variable                     m_wake;
+        std::condition_variable                     m_done;
+        const std::function<void(std::size_t)>*     m_task;
+        std::size_t                                 m_numTasks;
+        std::size_t                                 m_nextTask;
+        std::size_t                                 m_numFinished;
+        std::exception_ptr                          m_error;    // the first one a task threw
+        long long unsigned                          m_generation;
+        bool                                        m_stopping;
+    };
+
+    // Splits [begin, end) into numChunks contiguous chunks and calls func(chunkBegin, chunkEnd, chunkID)
+    // for each of them on the shared WorkerPool. The chunk boundaries only depend on the range and
+    // numChunks, so results that are merged in chunk order are deterministic.
+    template<typename Func>
+    void parallelForChunks(std::size_t begin, std::size_t end, std::size_t numChunks, Func func)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        const std::size_t count = end - begin;
+        numChunks = std::max<std::size_t>(1, std::min(numChunks, count));
+        if (numChunks == 1)
+        {
+            func(begin, end, 0);
+            return;
+        }
+
+        const std::size_t chunkSize = count / numChunks;
+        const std::size_t remainder = count % numChunks;
+        WorkerPool::getShared().run(numChunks, [begin, chunkSize, remainder, &func](std::size_t chunk)
+        {
+            const std::size_t chunkBegin = begin + chunk * chunkSize + std::min(chunk, remainder);
+            func(chunkBegin, chunkBegin + chunkSize + (chunk < remainder ? 1 : 0), chunk);
+        });
+    }
+
+    // Calls func(i) for every i in [begin, end). Ranges are split so that every worker gets at least
+    // minGrain iterations, small ranges just run on the calling thread.
+    template<typename Func>
+    void parallelFor(std::size_t begin, std::size_t end, Func func, std::size_t minGrain = 1)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        const std::size_t numChunks = std::min(getNumWorkers(), std::max<std::size_t>(1, (end - begin) / std::max<std::size_t>(1, minGrain)));
+        parallelForChunks(begin, end, numChunks, [&func](std::size_t chunkBegin, std::size_t chunkEnd, std::size_t)
+        {
+            for (std::size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                func(i);
+            }
+        });
+    }
+}
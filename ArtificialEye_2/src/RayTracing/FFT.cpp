@@ -0,0 +1,70 @@
+#include "FFT.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+bool ee::isPowerOfTwo(const std::size_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+ee::FFTPlan::FFTPlan(const std::size_t size) :
+    m_size(size),
+    m_reversed(size),
+    m_twiddles(size / 2)
+{
+    if (!isPowerOfTwo(size))
+    {
+        throw std::invalid_argument("The size of an FFT must be a power of two.");
+    }
+
+    std::size_t bits = 0;
+    while ((std::size_t(1) << bits) < size)
+    {
+        bits++;
+    }
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+        std::size_t reversed = 0;
+        for (std::size_t bit = 0; bit < bits; bit++)
+        {
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        }
+        m_reversed[i] = reversed;
+    }
+
+    for (std::size_t k = 0; k < m_twiddles.size(); k++)
+    {
+        const Float angle = -PI2 * k / size;
+        m_twiddles[k] = Complex(std::cos(angle), std::sin(angle));
+    }
+}
+
+void ee::FFTPlan::transform(Complex* const io_data, const std::size_t stride) const
+{
+    for (std::size_t i = 0; i < m_size; i++)
+    {
+        if (i < m_reversed[i])
+        {
+            std::swap(io_data[i * stride], io_data[m_reversed[i] * stride]);
+        }
+    }
+
+    // butterflies of twice the size each pass:
+    for (std::size_t half = 1, twiddleStep = m_size / 2; half < m_size; half *= 2, twiddleStep /= 2)
+    {
+        for (std::size_t start = 0; start < m_size; start += 2 * half)
+        {
+            for (std::size_t k = 0; k < half; k++)
+            {
+                Complex& even = io_data[(start + k) * stride];
+                Complex& odd = io_data[(start + k + half) * stride];
+                const Complex product = m_twiddles[k * twiddleStep] * odd;
+                odd = even - product;
+                even += product;
+            }
+        }
+    }
+}
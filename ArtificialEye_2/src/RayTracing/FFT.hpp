@@ -0,0 +1,33 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "../Types.hpp"
+
+namespace ee
+{
+    using Complex = std::complex<Float>;
+
+    // An in place radix-2 FFT of a fixed power of two size. The bit reversal and the twiddle factors are
+    // computed once, so a plan can be kept and used for every transform (of any number of rows or columns)
+    // without allocating.
+    class FFTPlan
+    {
+    public:
+        explicit FFTPlan(std::size_t size);
+
+        // forward transform (exp(-2 pi i k n / N), no scaling) of size elements that are stride elements apart
+        void transform(Complex* io_data, std::size_t stride = 1) const;
+
+        std::size_t getSize() const { return m_size; }
+
+    private:
+        std::size_t              m_size;
+        std::vector<std::size_t> m_reversed;  // element i goes to m_reversed[i]
+        std::vector<Complex>     m_twiddles;  // exp(-2 pi i k / N) for k < N / 2
+    };
+
+    bool isPowerOfTwo(std::size_t value);
+}
@@ -0,0 +1,82 @@
+#include "GradientIndex.hpp"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#undef min
+#undef max
+
+namespace
+{
+    // Cash-Karp tableau:
+    const ee::Float B21 = 1.0 / 5.0;
+    const ee::Float B31 = 3.0 / 40.0,       B32 = 9.0 / 40.0;
+    const ee::Float B41 = 3.0 / 10.0,       B42 = -9.0 / 10.0,  B43 = 6.0 / 5.0;
+    const ee::Float B51 = -11.0 / 54.0,     B52 = 5.0 / 2.0,    B53 = -70.0 / 27.0,     B54 = 35.0 / 27.0;
+    const ee::Float B61 = 1631.0 / 55296.0, B62 = 175.0 / 512.0, B63 = 575.0 / 13824.0, B64 = 44275.0 / 110592.0, B65 = 253.0 / 4096.0;
+
+    const ee::Float C1 = 37.0 / 378.0,  C3 = 250.0 / 621.0, C4 = 125.0 / 594.0, C6 = 512.0 / 1771.0;
+    const ee::Float D1 = C1 - 2825.0 / 27648.0, D3 = C3 - 18575.0 / 48384.0, D4 = C4 - 13525.0 / 55296.0, D5 = -277.0 / 14336.0, D6 = C6 - 0.25;
+}
+
+ee::GradientIndexField::GradientIndexField(const Float middleIndex, const Float surfaceIndex, const Mat4& invModelTrans) :
+    m_middleIndex(middleIndex),
+    m_indexDrop(surfaceIndex - middleIndex),
+    m_invModelTrans(invModelTrans)
+{
+}
+
+ee::Float ee::GradientIndexField::getIndex(const Vec3 point) const
+{
+    const Vec3 local = transPoint3(m_invModelTrans, point);
+    return m_middleIndex + m_indexDrop * std::min<Float>(1.0, glm::dot(local, local));
+}
+
+ee::Vec3 ee::GradientIndexField::calcRayCurvature(const Vec3 point) const
+{
+    const Vec3 local = transPoint3(m_invModelTrans, point);
+    const Float sqrRadius = glm::dot(local, local);
+    if (sqrRadius >= 1.0)
+    {
+        return Vec3();
+    }
+
+    // the gradient goes back to world space with the transpose of the inverse:
+    const Float index = m_middleIndex + m_indexDrop * sqrRadius;
+    const Vec3 localGradient = 2.0 * m_indexDrop * local;
+    return index * Vec3(glm::transpose(m_invModelTrans) * Vec4(localGradient, 0.0));
+}
+
+ee::GradientIndexRay ee::stepCashKarp(const GradientIndexField& field, const GradientIndexRay& ray, const Float dt, Float* const o_error)
+{
+    // the field doesn't depend on t, so every stage is just the curvature at the stage position:
+    const Vec3& r = ray.m_position;
+    const Vec3& v = ray.m_optDir;
+
+    const Vec3 v1 = v;
+    const Vec3 a1 = field.calcRayCurvature(r);
+
+    const Vec3 v2 = v + dt * (B21 * a1);
+    const Vec3 a2 = field.calcRayCurvature(r + dt * (B21 * v1));
+
+    const Vec3 v3 = v + dt * (B31 * a1 + B32 * a2);
+    const Vec3 a3 = field.calcRayCurvature(r + dt * (B31 * v1 + B32 * v2));
+
+    const Vec3 v4 = v + dt * (B41 * a1 + B42 * a2 + B43 * a3);
+    const Vec3 a4 = field.calcRayCurvature(r + dt * (B41 * v1 + B42 * v2 + B43 * v3));
+
+    const Vec3 v5 = v + dt * (B51 * a1 + B52 * a2 + B53 * a3 + B54 * a4);
+    const Vec3 a5 = field.calcRayCurvature(r + dt * (B51 * v1 + B52 * v2 + B53 * v3 + B54 * v4));
+
+    const Vec3 v6 = v + dt * (B61 * a1 + B62 * a2 + B63 * a3 + B64 * a4 + B65 * a5);
+    const Vec3 a6 = field.calcRayCurvature(r + dt * (B61 * v1 + B62 * v2 + B63 * v3 + B64 * v4 + B65 * v5));
+
+    GradientIndexRay result;
+    result.m_position = r + dt * (C1 * v1 + C3 * v3 + C4 * v4 + C6 * v6);
+    result.m_optDir = v + dt * (C1 * a1 + C3 * a3 + C4 * a4 + C6 * a6);
+
+    const Vec3 positionError = dt * (D1 * v1 + D3 * v3 + D4 * v4 + D5 * v5 + D6 * v6);
+    const Vec3 dirError = dt * (D1 * a1 + D3 * a3 + D4 * a4 + D5 * a5 + D6 * a6);
+    *o_error = std::max(glm::length(positionError), glm::length(dirError));
+    return result;
+}
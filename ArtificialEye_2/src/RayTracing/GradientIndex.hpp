@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../Types.hpp"
+
+namespace ee
+{
+    // The refractive index of the crystalline lens, highest in the nucleus and falling off towards the
+    // surface: n = middle + (surface - middle) * r^2, with r the distance from the center of the lens in its
+    // object space (where the undeformed lens is the unit sphere), and the surface index from r = 1 on.
+    class GradientIndexField
+    {
+    public:
+        GradientIndexField(Float middleIndex, Float surfaceIndex, const Mat4& invModelTrans);
+
+        Float getIndex(Vec3 point) const;
+
+        // n * grad(n), the curvature of the rays (in world space)
+        Vec3 calcRayCurvature(Vec3 point) const;
+
+    private:
+        Float m_middleIndex;
+        Float m_indexDrop;  // surface - middle
+        Mat4  m_invModelTrans;
+    };
+
+    // A ray in the field, with the optical direction n * dr/ds. Along the parameter t (with ds = n dt) the
+    // ray equation d/ds(n dr/ds) = grad(n) becomes dr/dt = m_optDir, d(m_optDir)/dt = n * grad(n).
+    struct GradientIndexRay
+    {
+        Vec3 m_position;
+        Vec3 m_optDir;
+    };
+
+    // One Runge-Kutta Cash-Karp step of size dt, o_error gets the difference between the 5th and the embedded
+    // 4th order solution (the larger of the position and the direction error)
+    GradientIndexRay stepCashKarp(const GradientIndexField& field, const GradientIndexRay& ray, Float dt, Float* o_error);
+}
@@ -0,0 +1,125 @@
+#include "MTF.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#undef min
+#undef max
+
+namespace
+{
+    const std::size_t FFT_GRAIN            = 8;  // rows or columns per worker
+    const ee::Float   MIN_DC               = 1.0e-300;
+    const std::size_t RING_ANGLES_PER_UNIT = 8;  // samples on a circle per unit of radius (in frequency steps)
+}
+
+ee::MTF::MTF(const unsigned resolution) :
+    m_resolution(resolution),
+    m_plan(resolution),
+    m_buffer(resolution * resolution),
+    m_otfMagnitude(resolution * resolution, 0.0),
+    m_radial(resolution / 2 + 1, 0.0),
+    m_tangential(resolution / 2 + 1, 0.0),
+    m_sagittal(resolution / 2 + 1, 0.0),
+    m_frequencyStep(0.0)
+{
+    // the OTF is periodic, so the samples on the outermost circle wrap around to the other side:
+    const std::size_t size = resolution;
+    const Float center = static_cast<Float>(resolution / 2);
+    m_ringStarts.push_back(0);
+    for (std::size_t ring = 0; ring <= size / 2; ring++)
+    {
+        const std::size_t numAngles = std::max<std::size_t>(1, RING_ANGLES_PER_UNIT * ring);
+        for (std::size_t angle = 0; angle < numAngles; angle++)
+        {
+            const Float theta = PI2 * angle / numAngles;
+            const Float x = center + ring * std::cos(theta);
+            const Float y = center + ring * std::sin(theta);
+            const Float x0 = std::floor(x);
+            const Float y0 = std::floor(y);
+            const Float fx = x - x0;
+            const Float fy = y - y0;
+            const std::size_t ix = static_cast<std::size_t>(x0 + size) % size;
+            const std::size_t iy = static_cast<std::size_t>(y0 + size) % size;
+
+            RingSample sample;
+            sample.m_index[0] = iy * size + ix;
+            sample.m_index[1] = iy * size + (ix + 1) % size;
+            sample.m_index[2] = ((iy + 1) % size) * size + ix;
+            sample.m_index[3] = ((iy + 1) % size) * size + (ix + 1) % size;
+            sample.m_weight[0] = (1.0 - fx) * (1.0 - fy);
+            sample.m_weight[1] = fx * (1.0 - fy);
+            sample.m_weight[2] = (1.0 - fx) * fy;
+            sample.m_weight[3] = fx * fy;
+            m_ringSamples.push_back(sample);
+        }
+        m_ringStarts.push_back(m_ringSamples.size());
+    }
+}
+
+void ee::MTF::compute(const std::vector<Float>& psf, const Float pixelSize)
+{
+    const std::size_t size = m_resolution;
+    for (std::size_t i = 0; i < size * size; i++)
+    {
+        m_buffer[i] = Complex(i < psf.size() ? psf[i] : 0.0, 0.0);
+    }
+
+    parallelFor(0, size, [this, size](std::size_t row)
+    {
+        m_plan.transform(&m_buffer[row * size]);
+    }, FFT_GRAIN);
+    parallelFor(0, size, [this, size](std::size_t column)
+    {
+        m_plan.transform(&m_buffer[column], size);
+    }, FFT_GRAIN);
+
+    // normalize to zero frequency and move it to the center:
+    const Float dc = std::max(std::abs(m_buffer[0]), MIN_DC);
+    const std::size_t half = size / 2;
+    for (std::size_t v = 0; v < size; v++)
+    {
+        for (std::size_t u = 0; u < size; u++)
+        {
+            m_otfMagnitude[((v + half) % size) * size + (u + half) % size] = std::abs(m_buffer[v * size + u]) / dc;
+        }
+    }
+
+    for (std::size_t ring = 0; ring <= half; ring++)
+    {
+        Float sum = 0.0;
+        for (std::size_t i = m_ringStarts[ring]; i < m_ringStarts[ring + 1]; i++)
+        {
+            const RingSample& sample = m_ringSamples[i];
+            for (int k = 0; k < 4; k++)
+            {
+                sum += sample.m_weight[k] * m_otfMagnitude[sample.m_index[k]];
+            }
+        }
+        m_radial[ring] = sum / (m_ringStarts[ring + 1] - m_ringStarts[ring]);
+
+        // the highest frequency only exists on the negative side:
+        const std::size_t offset = ring < half ? half + ring : 0;
+        m_tangential[ring] = m_otfMagnitude[offset * size + half];
+        m_sagittal[ring] = m_otfMagnitude[half * size + offset];
+    }
+
+    m_frequencyStep = 1.0 / (size * pixelSize);
+}
+
+ee::Float ee::MTF::calcFrequency(const std::vector<Float>& curve, const Float modulation) const
+{
+    for (std::size_t i = 1; i < curve.size(); i++)
+    {
+        if (curve[i] <= modulation)
+        {
+            // linear between the samples:
+            const Float drop = curve[i - 1] - curve[i];
+            const Float along = drop > 0.0 ? (curve[i - 1] - modulation) / drop : 0.0;
+            return (i - 1 + std::min<Float>(1.0, std::max<Float>(0.0, along))) * m_frequencyStep;
+        }
+    }
+
+    return curve.empty() ? 0.0 : (curve.size() - 1) * m_frequencyStep;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../Types.hpp"
+#include "FFT.hpp"
+
+namespace ee
+{
+    // The modulation transfer function of a sampled PSF (like SpotDiagram::getPSF()): the magnitude of its
+    // 2D Fourier transform (the OTF), normalized to 1 at zero frequency. The transform is done separably,
+    // rows and then columns in parallel, with a plan and buffers that are kept between computations, so this
+    // can run after every change of the lens.
+    class MTF
+    {
+    public:
+        // the PSF has resolution x resolution pixels, resolution has to be a power of two
+        explicit MTF(unsigned resolution);
+
+        // psf is row major (y rows, x columns), pixelSize is the width of a pixel on the retina
+        void compute(const std::vector<Float>& psf, Float pixelSize);
+
+        // |OTF| with zero frequency in the center: frequency (u, v) is at
+        // [(v + resolution / 2) * resolution + u + resolution / 2] for -resolution / 2 <= u, v < resolution / 2
+        const std::vector<Float>& getOTFMagnitude() const { return m_otfMagnitude; }
+
+        // curves over the frequencies i * getFrequencyStep(), i <= resolution / 2:
+        const std::vector<Float>& getRadialMTF() const { return m_radial; }         // averaged over every direction
+        const std::vector<Float>& getTangentialMTF() const { return m_tangential; } // along y
+        const std::vector<Float>& getSagittalMTF() const { return m_sagittal; }     // along x
+
+        // cycles per unit length on the retina
+        Float getFrequencyStep() const { return m_frequencyStep; }
+
+        // the lowest frequency at which the curve drops to the modulation (like 0.5 for MTF50), the highest
+        // frequency if it never does
+        Float calcFrequency(const std::vector<Float>& curve, Float modulation) const;
+
+        unsigned getResolution() const { return m_resolution; }
+
+    private:
+        const unsigned m_resolution;
+        FFTPlan        m_plan;
+
+        // bilinear samples of the OTF on circles around zero frequency, for the radial average
+        struct RingSample
+        {
+            std::size_t m_index[4];
+            Float       m_weight[4];
+        };
+
+        std::vector<Complex>     m_buffer;
+        std::vector<RingSample>  m_ringSamples;
+        std::vector<std::size_t> m_ringStarts;  // the samples of ring i are [m_ringStarts[i], m_ringStarts[i + 1])
+
+        std::vector<Float>    m_otfMagnitude;
+        std::vector<Float>    m_radial;
+        std::vector<Float>    m_tangential;
+        std::vector<Float>    m_sagittal;
+        Float                 m_frequencyStep;
+    };
+}
@@ -0,0 +1,443 @@
+#include "MeshBVH.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#undef min
+#undef max
+
+namespace
+{
+    const int      NUM_BINS            = 16;
+    const uint32_t MAX_LEAF_SIZE       = ee::TRIANGLE_PACKET_SIZE; // a leaf is usually a single packet
+    const uint32_t MAX_FORCED_LEAF     = 16;   // larger leaves are always split, even if the SAH doesn't gain anything
+    const int      MAX_DEPTH           = 64;   // the traversal stack is this deep
+    const ee::Float TRAVERSAL_COST     = 1.0;  // relative to intersecting a triangle
+    const ee::Float MIN_DIR            = 1.0e-30;
+
+    const ee::Float REBUILD_COST_RATIO = 1.5;  // rebuild once a refit is this much slower than the build was
+    const std::size_t REFIT_GRAIN      = 1024;
+
+    ee::Float surfaceArea(const ee::Vec3& minPos, const ee::Vec3& maxPos)
+    {
+        const ee::Vec3 extent = maxPos - minPos;
+        return 2.0 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    struct Bin
+    {
+        ee::Vec3    m_min;
+        ee::Vec3    m_max;
+        std::size_t m_count;
+
+        Bin() :
+            m_min(std::numeric_limits<ee::Float>::max()),
+            m_max(-std::numeric_limits<ee::Float>::max()),
+            m_count(0)
+        {
+        }
+
+        void grow(const ee::Vec3& minPos, const ee::Vec3& maxPos)
+        {
+            m_min = glm::min(m_min, minPos);
+            m_max = glm::max(m_max, maxPos);
+        }
+    };
+
+    // the entry distance of the ray into the box, or max if it misses (or is past maxDist)
+    ee::Float intersectBox(const ee::BVHNode& node, const ee::Vec3& origin, const ee::Vec3& invDir, const ee::Float maxDist)
+    {
+        const ee::Vec3 t0 = (node.m_min - origin) * invDir;
+        const ee::Vec3 t1 = (node.m_max - origin) * invDir;
+        const ee::Vec3 tNear = glm::min(t0, t1);
+        const ee::Vec3 tFar = glm::max(t0, t1);
+
+        const ee::Float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0));
+        const ee::Float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDist));
+        return enter <= exit ? enter : std::numeric_limits<ee::Float>::max();
+    }
+}
+
+ee::MeshBVH::MeshBVH() :
+    m_mesh(nullptr),
+    m_updateCount(0),
+    m_topologyCount(0),
+    m_buildCost(0.0),
+    m_numBuilds(0),
+    m_numRefits(0)
+{
+}
+
+void ee::MeshBVH::build(const MeshSnapshot& mesh)
+{
+    m_mesh = mesh.m_mesh;
+    m_updateCount = mesh.m_updateCount;
+    m_topologyCount = mesh.m_topologyCount;
+    m_modelTrans = mesh.m_modelTrans;
+    m_invModelTrans = mesh.m_invModelTrans;
+    m_numBuilds++;
+
+    const std::vector<Vertex>& vertices = *mesh.m_vertices;
+    const std::vector<MeshFace>& faces = *mesh.m_faces;
+
+    m_faceIDs.resize(faces.size());
+    m_centroids.resize(faces.size());
+    m_faceMin.resize(faces.size());
+    m_faceMax.resize(faces.size());
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        const Vec3& p0 = vertices[faces[i](0)].m_position;
+        const Vec3& p1 = vertices[faces[i](1)].m_position;
+        const Vec3& p2 = vertices[faces[i](2)].m_position;
+
+        m_faceIDs[i] = i;
+        m_faceMin[i] = glm::min(p0, glm::min(p1, p2));
+        m_faceMax[i] = glm::max(p0, glm::max(p1, p2));
+        m_centroids[i] = (p0 + p1 + p2) / 3.0;
+    }
+
+    m_nodes.clear();
+    m_nodes.reserve(2 * faces.size());
+    for (std::vector<uint32_t>& level : m_levels)
+    {
+        level.clear();
+    }
+
+    if (!faces.empty())
+    {
+        buildNode(0, faces.size(), 0);
+    }
+
+    // the triangles of every leaf go into consecutive packets:
+    std::size_t numPackets = 0;
+    for (BVHNode& node : m_nodes)
+    {
+        if (node.m_count > 0)
+        {
+            node.m_packets = static_cast<uint32_t>(numPackets);
+            numPackets += (node.m_count + TRIANGLE_PACKET_SIZE - 1) / TRIANGLE_PACKET_SIZE;
+        }
+    }
+
+    m_packets.resize(numPackets);
+    for (std::size_t nodeID = 0; nodeID < m_nodes.size(); nodeID++)
+    {
+        if (m_nodes[nodeID].m_count > 0)
+        {
+            fillLeaf(nodeID, vertices, faces);
+        }
+    }
+
+    m_buildCost = calcCost();
+}
+
+void ee::MeshBVH::update(const MeshSnapshot& mesh)
+{
+    if (mesh.m_mesh != m_mesh || mesh.m_topologyCount != m_topologyCount)
+    {
+        build(mesh);
+        return;
+    }
+
+    m_modelTrans = mesh.m_modelTrans;
+    m_invModelTrans = mesh.m_invModelTrans;
+    if (mesh.m_updateCount == m_updateCount)
+    {
+        return;
+    }
+
+    refit(mesh);
+    if (calcCost() > REBUILD_COST_RATIO * m_buildCost)
+    {
+        build(mesh);
+    }
+}
+
+void ee::MeshBVH::refit(const MeshSnapshot& mesh)
+{
+    m_updateCount = mesh.m_updateCount;
+    m_numRefits++;
+
+    const std::vector<Vertex>& vertices = *mesh.m_vertices;
+    const std::vector<MeshFace>& faces = *mesh.m_faces;
+
+    // the leaves (and their triangles) first, every leaf is independent:
+    parallelFor(0, m_nodes.size(), [this, &vertices, &faces](const std::size_t nodeID)
+    {
+        if (m_nodes[nodeID].m_count > 0)
+        {
+            fillLeaf(nodeID, vertices, faces);
+        }
+    }, REFIT_GRAIN);
+
+    // then the interior nodes from the deepest level up, the nodes of a level don't depend on each other:
+    for (std::size_t depth = m_levels.size(); depth-- > 0;)
+    {
+        const std::vector<uint32_t>& level = m_levels[depth];
+        parallelFor(0, level.size(), [this, &level](const std::size_t i)
+        {
+            BVHNode& node = m_nodes[level[i]];
+            const BVHNode& left = m_nodes[level[i] + 1];
+            const BVHNode& right = m_nodes[node.m_offset];
+            node.m_min = glm::min(left.m_min, right.m_min);
+            node.m_max = glm::max(left.m_max, right.m_max);
+        }, REFIT_GRAIN);
+    }
+}
+
+void ee::MeshBVH::fillLeaf(const std::size_t nodeID, const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces)
+{
+    BVHNode& node = m_nodes[nodeID];
+    Vec3 minPos(std::numeric_limits<Float>::max());
+    Vec3 maxPos(-std::numeric_limits<Float>::max());
+    for (uint32_t i = 0; i < node.m_count; i++)
+    {
+        const MeshFace& face = faces[m_faceIDs[node.m_offset + i]];
+        const Vec3& p0 = vertices[face(0)].m_position;
+        const Vec3& p1 = vertices[face(1)].m_position;
+        const Vec3& p2 = vertices[face(2)].m_position;
+
+        setPacketTriangle(&m_packets[node.m_packets + i / TRIANGLE_PACKET_SIZE], i % TRIANGLE_PACKET_SIZE, p0, p1, p2);
+        minPos = glm::min(minPos, glm::min(p0, glm::min(p1, p2)));
+        maxPos = glm::max(maxPos, glm::max(p0, glm::max(p1, p2)));
+    }
+
+    // the lanes after the last triangle never hit:
+    for (uint32_t i = node.m_count; i % TRIANGLE_PACKET_SIZE != 0; i++)
+    {
+        clearPacketTriangle(&m_packets[node.m_packets + i / TRIANGLE_PACKET_SIZE], i % TRIANGLE_PACKET_SIZE);
+    }
+
+    node.m_min = minPos;
+    node.m_max = maxPos;
+}
+
+ee::Float ee::MeshBVH::calcCost() const
+{
+    if (m_nodes.empty())
+    {
+        return 0.0;
+    }
+
+    const Float rootArea = surfaceArea(m_nodes[0].m_min, m_nodes[0].m_max);
+    if (rootArea <= 0.0)
+    {
+        return Float(m_faceIDs.size());
+    }
+
+    Float cost = 0.0;
+    for (const BVHNode& node : m_nodes)
+    {
+        cost += surfaceArea(node.m_min, node.m_max) * (node.m_count > 0 ? Float(node.m_count) : TRAVERSAL_COST);
+    }
+    return cost / rootArea;
+}
+
+void ee::MeshBVH::buildNode(const std::size_t begin, const std::size_t end, const int depth)
+{
+    const std::size_t nodeID = m_nodes.size();
+    m_nodes.push_back(BVHNode());
+
+    Vec3 minPos(std::numeric_limits<Float>::max());
+    Vec3 maxPos(-std::numeric_limits<Float>::max());
+    Vec3 minCentroid = minPos;
+    Vec3 maxCentroid = maxPos;
+    for (std::size_t i = begin; i < end; i++)
+    {
+        const std::size_t face = m_faceIDs[i];
+        minPos = glm::min(minPos, m_faceMin[face]);
+        maxPos = glm::max(maxPos, m_faceMax[face]);
+        minCentroid = glm::min(minCentroid, m_centroids[face]);
+        maxCentroid = glm::max(maxCentroid, m_centroids[face]);
+    }
+
+    m_nodes[nodeID].m_min = minPos;
+    m_nodes[nodeID].m_max = maxPos;
+    m_nodes[nodeID].m_offset = static_cast<uint32_t>(begin);
+    m_nodes[nodeID].m_count = static_cast<uint32_t>(end - begin);
+
+    const std::size_t count = end - begin;
+    if (count <= MAX_LEAF_SIZE || depth + 1 >= MAX_DEPTH)
+    {
+        return;
+    }
+
+    // find the cheapest split of the binned centroids over all axes:
+    int bestAxis = -1;
+    int bestSplit = 0;
+    Float bestCost = std::numeric_limits<Float>::max();
+    const Vec3 centroidExtent = maxCentroid - minCentroid;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (centroidExtent[axis] <= 0.0)
+        {
+            continue;
+        }
+
+        const Float binScale = NUM_BINS / centroidExtent[axis];
+        Bin bins[NUM_BINS];
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const std::size_t face = m_faceIDs[i];
+            const int bin = std::min(NUM_BINS - 1, static_cast<int>((m_centroids[face][axis] - minCentroid[axis]) * binScale));
+            bins[bin].grow(m_faceMin[face], m_faceMax[face]);
+            bins[bin].m_count++;
+        }
+
+        // sweep from the right, then from the left:
+        Float rightArea[NUM_BINS];
+        std::size_t rightCount[NUM_BINS];
+        Bin right;
+        for (int b = NUM_BINS - 1; b > 0; b--)
+        {
+            right.grow(bins[b].m_min, bins[b].m_max);
+            right.m_count += bins[b].m_count;
+            rightArea[b] = right.m_count ? surfaceArea(right.m_min, right.m_max) : 0.0;
+            rightCount[b] = right.m_count;
+        }
+
+        Bin left;
+        for (int b = 0; b < NUM_BINS - 1; b++)
+        {
+            left.grow(bins[b].m_min, bins[b].m_max);
+            left.m_count += bins[b].m_count;
+            if (left.m_count == 0 || rightCount[b + 1] == 0)
+            {
+                continue;
+            }
+
+            const Float cost = surfaceArea(left.m_min, left.m_max) * left.m_count + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    const Float parentArea = surfaceArea(minPos, maxPos);
+    const bool splitPays = bestAxis >= 0 && (parentArea <= 0.0 || TRAVERSAL_COST + bestCost / parentArea < Float(count));
+    if (!splitPays && count <= MAX_FORCED_LEAF)
+    {
+        return;
+    }
+
+    std::size_t middle = begin;
+    if (bestAxis >= 0)
+    {
+        const Float binScale = NUM_BINS / centroidExtent[bestAxis];
+        const Float minCentroidAxis = minCentroid[bestAxis];
+        const std::vector<Vec3>& centroids = m_centroids;
+        middle = std::partition(m_faceIDs.begin() + begin, m_faceIDs.begin() + end, [&](const std::size_t face)
+        {
+            return std::min(NUM_BINS - 1, static_cast<int>((centroids[face][bestAxis] - minCentroidAxis) * binScale)) <= bestSplit;
+        }) - m_faceIDs.begin();
+    }
+
+    if (middle == begin || middle == end)
+    {
+        // every centroid is in the same place, split in the middle of the list:
+        middle = begin + count / 2;
+    }
+
+    m_nodes[nodeID].m_count = 0;
+    if (m_levels.size() <= static_cast<std::size_t>(depth))
+    {
+        m_levels.resize(depth + 1);
+    }
+    m_levels[depth].push_back(static_cast<uint32_t>(nodeID));
+
+    buildNode(begin, middle, depth + 1);
+    m_nodes[nodeID].m_offset = static_cast<uint32_t>(m_nodes.size());
+    buildNode(middle, end, depth + 1);
+}
+
+std::pair<std::size_t, ee::Vec3> ee::MeshBVH::nearestIntersection(const Ray worldRay, const std::size_t ignore) const
+{
+    std::size_t minFace = m_faceIDs.size();
+    Float minDist = std::numeric_limits<Float>::max();
+    if (m_nodes.empty())
+    {
+        return std::make_pair(minFace, Vec3());
+    }
+
+    // the transform is affine, so the distance along the ray is the same in object space:
+    const Ray ray(transPoint3(m_invModelTrans, worldRay.m_origin), transVector3(m_invModelTrans, worldRay.m_dir));
+
+    // zero components would give 0 * inf in the slab test:
+    Vec3 invDir;
+    for (int k = 0; k < 3; k++)
+    {
+        invDir[k] = 1.0 / (std::abs(ray.m_dir[k]) > MIN_DIR ? ray.m_dir[k] : (ray.m_dir[k] < 0.0 ? -MIN_DIR : MIN_DIR));
+    }
+
+    uint32_t stack[MAX_DEPTH];
+    int stackSize = 0;
+    uint32_t nodeID = 0;
+    if (intersectBox(m_nodes[0], ray.m_origin, invDir, minDist) == std::numeric_limits<Float>::max())
+    {
+        return std::make_pair(minFace, Vec3());
+    }
+
+    while (true)
+    {
+        const BVHNode& node = m_nodes[nodeID];
+        if (node.m_count > 0)
+        {
+            const uint32_t end = node.m_offset + node.m_count;
+            for (uint32_t packet = node.m_packets, first = node.m_offset; first < end; packet++, first += TRIANGLE_PACKET_SIZE)
+            {
+                Float dists[TRIANGLE_PACKET_SIZE];
+                intersectTrianglePacket(ray, m_packets[packet], dists);
+
+                for (uint32_t i = first; i < std::min<uint32_t>(end, first + TRIANGLE_PACKET_SIZE); i++)
+                {
+                    const std::size_t face = m_faceIDs[i];
+                    const Float dist = dists[i - first];
+                    if (face != ignore && dist > 0.0 && (dist < minDist || (dist == minDist && face < minFace)))
+                    {
+                        minDist = dist;
+                        minFace = face;
+                    }
+                }
+            }
+        }
+        else
+        {
+            // visit the nearer child first, the other one only if it can still be closer:
+            uint32_t nearChild = nodeID + 1;
+            uint32_t farChild = node.m_offset;
+            Float nearDist = intersectBox(m_nodes[nearChild], ray.m_origin, invDir, minDist);
+            Float farDist = intersectBox(m_nodes[farChild], ray.m_origin, invDir, minDist);
+            if (farDist < nearDist)
+            {
+                std::swap(nearChild, farChild);
+                std::swap(nearDist, farDist);
+            }
+
+            if (nearDist != std::numeric_limits<Float>::max())
+            {
+                if (farDist != std::numeric_limits<Float>::max())
+                {
+                    stack[stackSize++] = farChild;
+                }
+                nodeID = nearChild;
+                continue;
+            }
+        }
+
+        if (stackSize == 0)
+        {
+            break;
+        }
+        nodeID = stack[--stackSize];
+    }
+
+    if (minFace == m_faceIDs.size())
+    {
+        return std::make_pair(minFace, Vec3());
+    }
+    return std::make_pair(minFace, worldRay.m_origin + worldRay.m_dir * minDist);
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../Types.hpp"
+#include "../Rendering/Modeling/Mesh.hpp"
+#include "TrianglePacket.hpp"
+
+namespace ee
+{
+    // Node of the flattened hierarchy (depth first), the first child of an interior node directly follows it.
+    struct BVHNode
+    {
+        Vec3     m_min;
+        Vec3     m_max;
+        uint32_t m_offset;  // first triangle of a leaf, second child of an interior node
+        uint32_t m_count;   // number of triangles of a leaf, 0 for an interior node
+        uint32_t m_packets; // first packet of the triangles of a leaf
+    };
+
+    // Bounding volume hierarchy over the triangles of a mesh, built with a binned surface area heuristic.
+    // Answers the same queries as nearestIntersectionMesh in O(log faces) instead of O(faces). The hierarchy
+    // is in object space and rays are moved into it, so the model transform can change without a refit.
+    class MeshBVH
+    {
+    public:
+        MeshBVH();
+
+        // builds the hierarchy over the vertices of the snapshot
+        void build(const MeshSnapshot& mesh);
+
+        // Brings the hierarchy up to date with the snapshot of the mesh it was built for: nothing if the vertices
+        // didn't change, a refit if only they did and a build if the faces changed (or it is another mesh) or the
+        // refit made the hierarchy too slow (see calcCost). Takes the model transform of the snapshot in any case.
+        void update(const MeshSnapshot& mesh);
+
+        // Moves the triangles to the vertices of the snapshot (of the same faces) and updates the bounds bottom up
+        // (in parallel), keeps the tree itself. O(faces), but the boxes overlap more the further the mesh deforms.
+        void refit(const MeshSnapshot& mesh);
+
+        // expected cost of a ray (surface area heuristic) in triangle tests, relative to hitting the root box
+        Float calcCost() const;
+
+        // returns the nearest intersection (point) and which face (getNumFaces() if there is none), the ignored face
+        // is skipped (like nearestIntersectionMesh)
+        std::pair<std::size_t, Vec3> nearestIntersection(Ray ray, std::size_t ignore = ULONG_MAX) const;
+
+        std::size_t getNumFaces() const { return m_faceIDs.size(); }
+        const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+
+        long long unsigned getNumBuilds() const { return m_numBuilds; }
+        long long unsigned getNumRefits() const { return m_numRefits; }
+
+    private:
+        std::vector<BVHNode>        m_nodes;
+        std::vector<TrianglePacket> m_packets;  // the triangles of the leaves, four at a time for the SIMD intersection
+        std::vector<std::size_t>    m_faceIDs;  // face of each triangle in the mesh, in the order of the leaves
+
+        std::vector<std::vector<uint32_t>> m_levels; // interior nodes by depth, for the bottom up refit
+
+        // the version of the mesh the hierarchy is for:
+        const Mesh*         m_mesh;
+        long long unsigned  m_updateCount;
+        long long unsigned  m_topologyCount;
+        Mat4                m_modelTrans;
+        Mat4                m_invModelTrans;
+        Float               m_buildCost;
+
+        long long unsigned  m_numBuilds;
+        long long unsigned  m_numRefits;
+
+        // build state:
+        std::vector<Vec3> m_centroids;
+        std::vector<Vec3> m_faceMin;
+        std::vector<Vec3> m_faceMax;
+
+        void buildNode(std::size_t begin, std::size_t end, int depth);
+        void fillLeaf(std::size_t nodeID, const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces);
+    };
+}
\ No newline at end of file
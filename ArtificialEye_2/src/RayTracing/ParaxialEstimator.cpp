@@ -0,0 +1,109 @@
+#include "ParaxialEstimator.hpp"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "../Alglib/interpolation.h"
+
+namespace
+{
+    const ee::Float        MIN_EXIT_ANGLE = 1.0e-12; // |sine| of rays that are taken as parallel to the axis
+    const alglib::ae_int_t FIT_TERMS      = 3;       // 1, h^2 and h^4
+
+    // fits y over x = h^2 with FIT_TERMS terms, o_coeffs gets them from the constant term up
+    bool fitEvenPolynomial(const std::vector<ee::Float>& heights, const std::vector<ee::Float>& values, ee::Float o_coeffs[FIT_TERMS])
+    {
+        const alglib::ae_int_t n = static_cast<alglib::ae_int_t>(heights.size());
+        alglib::real_1d_array x;
+        alglib::real_1d_array y;
+        x.setlength(n);
+        y.setlength(n);
+        for (alglib::ae_int_t i = 0; i < n; i++)
+        {
+            x[i] = heights[i] * heights[i];
+            y[i] = values[i];
+        }
+
+        alglib::ae_int_t info;
+        alglib::barycentricinterpolant fit;
+        alglib::polynomialfitreport report;
+        alglib::polynomialfit(x, y, n, FIT_TERMS, info, fit, report);
+        if (info <= 0)
+        {
+            return false;
+        }
+
+        alglib::real_1d_array coeffs;
+        alglib::polynomialbar2pow(fit, coeffs);
+        for (alglib::ae_int_t i = 0; i < FIT_TERMS; i++)
+        {
+            o_coeffs[i] = i < coeffs.length() ? coeffs[i] : 0.0;
+        }
+        return true;
+    }
+}
+
+ee::ParaxialEstimator::ParaxialEstimator(const Vec3 axisPoint, const std::size_t numRays, const Float maxHeight, const Float imageRefractiveIndex) :
+    m_maxHeight(maxHeight),
+    m_imageRefractiveIndex(imageRefractiveIndex),
+    m_valid(false),
+    m_backFocus(0.0),
+    m_focalLength(0.0),
+    m_power(0.0)
+{
+    m_sphericalAberration[0] = 0.0;
+    m_sphericalAberration[1] = 0.0;
+
+    // none on the axis, it never crosses it:
+    for (std::size_t i = 0; i < numRays; i++)
+    {
+        const Float height = maxHeight * (i + 1) / numRays;
+        m_fan.push_back(Ray(axisPoint + Vec3(height, 0.0, 0.0), Vec3(0.0, 0.0, 1.0)));
+    }
+}
+
+bool ee::ParaxialEstimator::estimate(RayTracer* const tracer)
+{
+    tracer->traceBundle(m_fan, &m_exitRays);
+
+    m_heights.clear();
+    m_crossings.clear();
+    m_focalLengths.clear();
+    for (std::size_t i = 0; i < m_fan.size(); i++)
+    {
+        const Ray& exit = m_exitRays[i];
+        const Float length = glm::length(exit.m_dir);
+        if (length == 0.0 || std::abs(exit.m_dir.x) <= MIN_EXIT_ANGLE * length)
+        {
+            continue;
+        }
+
+        const Float height = m_fan[i].m_origin.x;
+        m_heights.push_back(height);
+        m_crossings.push_back(exit.m_origin.z - exit.m_origin.x * exit.m_dir.z / exit.m_dir.x);
+        m_focalLengths.push_back(-height * length / exit.m_dir.x);
+    }
+
+    Float crossingCoeffs[FIT_TERMS];
+    Float focalCoeffs[FIT_TERMS];
+    m_valid = m_heights.size() >= static_cast<std::size_t>(FIT_TERMS) &&
+        fitEvenPolynomial(m_heights, m_crossings, crossingCoeffs) &&
+        fitEvenPolynomial(m_heights, m_focalLengths, focalCoeffs);
+    if (!m_valid)
+    {
+        return false;
+    }
+
+    m_backFocus = crossingCoeffs[0];
+    m_sphericalAberration[0] = crossingCoeffs[1];
+    m_sphericalAberration[1] = crossingCoeffs[2];
+    m_focalLength = focalCoeffs[0];
+    m_power = m_focalLength != 0.0 ? m_imageRefractiveIndex / m_focalLength : 0.0;
+    return true;
+}
+
+ee::Float ee::ParaxialEstimator::getLongitudinalAberration() const
+{
+    const Float sqrHeight = m_maxHeight * m_maxHeight;
+    return m_sphericalAberration[0] * sqrHeight + m_sphericalAberration[1] * sqrHeight * sqrHeight;
+}
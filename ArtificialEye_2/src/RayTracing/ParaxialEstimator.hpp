@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../Types.hpp"
+#include "RayTracer.hpp"
+
+namespace ee
+{
+    // Estimates the focal length, the optical power and the spherical aberration of the eye from a small fan
+    // of rays parallel to the optical axis (+z), at increasing heights along x. The axis crossings of the rays
+    // that leave the lens and their effective focal lengths (height / sine of the exit angle) are fit with
+    // polynomials in height^2, the constant terms are the paraxial (height -> 0) values. A fan of a few
+    // rays is enough, so this can run after every step of the simulation.
+    class ParaxialEstimator
+    {
+    public:
+        // the fan starts at axisPoint + (height, 0, 0), imageRefractiveIndex is the medium behind the lens
+        ParaxialEstimator(Vec3 axisPoint, std::size_t numRays, Float maxHeight, Float imageRefractiveIndex);
+
+        // false if too few rays crossed the axis for the fit
+        bool estimate(RayTracer* tracer);
+
+        bool isValid() const { return m_valid; }
+
+        // z of the paraxial focus
+        Float getBackFocus() const { return m_backFocus; }
+
+        // effective focal length, the power is n' / f (in inverse units of the scene)
+        Float getFocalLength() const { return m_focalLength; }
+        Float getPower() const { return m_power; }
+
+        // the axis crossing is z(h) = backFocus + c[0] * h^2 + c[1] * h^4
+        const Float* getSphericalAberration() const { return m_sphericalAberration; }
+
+        // longitudinal spherical aberration at the highest ray of the fan: z(maxHeight) - backFocus
+        Float getLongitudinalAberration() const;
+
+        std::size_t getNumCrossings() const { return m_heights.size(); }
+
+    private:
+        std::vector<Ray>   m_fan;
+        std::vector<Ray>   m_exitRays;
+        Float              m_maxHeight;
+        Float              m_imageRefractiveIndex;
+
+        // of the rays that crossed the axis:
+        std::vector<Float> m_heights;
+        std::vector<Float> m_crossings;
+        std::vector<Float> m_focalLengths;
+
+        bool               m_valid;
+        Float              m_backFocus;
+        Float              m_focalLength;
+        Float              m_power;
+        Float              m_sphericalAberration[2];
+    };
+}
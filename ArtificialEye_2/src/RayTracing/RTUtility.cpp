@@ -66,45 +66,41 @@ std::pair<std::size_t, ee::Vec3> ee::nearestIntersectionMesh(const Mesh* mesh, R
     Vec3 minPoint; // the point where the intersection would occur
     Float minDist = std::numeric_limits<Float>::max();
 
+    // intersect in object space, so only the ray is transformed (instead of every vertex). Distances along the
+    // ray are all scaled the same, the nearest hit doesn't change:
+    const Mat4 invModelTrans = mesh->getInvModelTrans();
+    const Ray objectRay(transPoint3(invModelTrans, ray.m_origin), transVector3(invModelTrans, ray.m_dir));
+
     for (std::size_t i = 0; i < mesh->getNumMeshFaces(); i++)
     {
         if (i != ignore)
         {
             const MeshFace& face = mesh->getMeshFace(i);
 
-            // transform those points:
-            Vec3 p0 = transPoint3(mesh->getModelTrans(), mesh->getVertex(face(0)).m_position);
-            Vec3 p1 = transPoint3(mesh->getModelTrans(), mesh->getVertex(face(1)).m_position);
-            Vec3 p2 = transPoint3(mesh->getModelTrans(), mesh->getVertex(face(2)).m_position);
+            const Vec3& p0 = mesh->getVertex(face(0)).m_position;
+            const Vec3& p1 = mesh->getVertex(face(1)).m_position;
+            const Vec3& p2 = mesh->getVertex(face(2)).m_position;
 
-            const auto result = intersectTriangle(ray, p0, p1, p2);
+            const auto result = intersectTriangle(objectRay, p0, p1, p2);
             if (result.first) // there was an intersection
             {
-                Vec3 diff = result.second - ray.m_origin;
+                Vec3 diff = result.second - objectRay.m_origin;
                 const Float len = glm::length(diff); // find the length
                 if (len < minDist)
                 {
                     minDist  = len;
                     minFace  = i;
                     minPoint = result.second;
-
-                    //float minX = glm::min(glm::min(p0.x, p1.x), p2.x);
-                    //float maxX = glm::max(glm::max(p0.x, p1.x), p2.x);
-                    //assert(minX < result.second.x && result.second.x < maxX);
-
-                    //float minY = glm::min(glm::min(p0.y, p1.y), p2.y);
-                    //float maxY = glm::max(glm::max(p0.y, p1.y), p2.y);
-                    //assert(minY < result.second.y && result.second.y < maxY);
-
-                    //float minZ = glm::min(glm::min(p0.z, p1.z), p2.z);
-                    //float maxZ = glm::max(glm::max(p0.z, p1.z), p2.z);
-                    //assert(minZ < result.second.z && result.second.z < maxZ);
                 }
             }
         }
     }
 
-    return std::make_pair(minFace, minPoint);
+    if (minFace == mesh->getNumMeshFaces())
+    {
+        return std::make_pair(minFace, Vec3());
+    }
+    return std::make_pair(minFace, transPoint3(mesh->getModelTrans(), minPoint));
 }
 
 ee::Vec3 ee::cust::refract(const Vec3& I, const Vec3& N, const Float eta)
@@ -1,8 +1,23 @@
 #include "RayTracer.hpp"
+#include "../Parallel.hpp"
 
 #undef min
 #undef max
 
+namespace
+{
+    const std::size_t RAY_GRAIN = 64; // rays per task at least
+
+    // marching through the gradient index:
+    const ee::Float   GRIN_TOLERANCE    = 1.0e-8;  // largest error of a step
+    const ee::Float   GRIN_MIN_STEP     = 1.0e-6;  // in units of length along the ray
+    const ee::Float   GRIN_SAFETY       = 0.9;     // the step size control aims this much below the tolerance
+    const ee::Float   GRIN_MIN_SCALE    = 0.2;
+    const ee::Float   GRIN_MAX_SCALE    = 5.0;
+    const ee::Float   GRIN_SURFACE_DIST = 1.0e-9;  // the ray has left the lens this close to the surface
+    const int         MAX_GRIN_STEPS    = 256;
+}
+
 ee::RayTracer& ee::RayTracer::initialize(std::vector<Vec3> positions, Lens sphere, RayTracerParam param)
 {
     static RayTracer rayTracer(positions, sphere, param);
@@ -11,24 +26,100 @@ ee::RayTracer& ee::RayTracer::initialize(std::vector<Vec3> positions, Lens spher
 
 void ee::RayTracer::raytrace()
 {
-    const Float radialInc = 1.0 / m_parameters.m_heightResolution;
-    const Float circInc = (PI2 * radialInc) / m_parameters.m_widthResolution; // this is the base that defines difference between points
-                                                                                               // this is to maintain equal distribution
-    // this can easily be parallized if it becomes too hard:
-    for (int i = 0; i < m_rayOrigins.size(); i++) // because there will be 3 different rays
+    traceRays();
+    presentRays();
+}
+
+void ee::RayTracer::traceRays()
+{
+    // every ray of the trace sees the same version of the mesh:
+    const Mesh* const lensMesh = m_limitSurface ? m_limitSurface->getMesh() : m_lens.getMesh();
+    m_lensSnapshot = lensMesh->getSnapshot();
+
+    // the lens deforms between frames but keeps its faces, so the hierarchy is usually just refit:
+    m_lensBVH.update(m_lensSnapshot);
+
+    // every ray writes only its own slot:
+    const std::size_t numPoints = m_cachedPoints.size();
+    parallelFor(0, m_rayPaths.size(), [this, numPoints](const std::size_t index)
     {
-        m_resultColors[i] = raytrace(i, radialInc, circInc);
+        const Vec3& origin = m_rayOrigins[index / numPoints];
+        const Vec3& point = m_cachedPoints[index % numPoints];
+        const Ray currRay(Vec3(point.x, point.y, origin.z), Vec3(0.0, 0.0, 1.0)); // point - origin);
+        m_rayHits[index] = lensRefract(currRay, &m_rayPaths[index], static_cast<unsigned>(index % numPoints));
+    }, RAY_GRAIN);
+
+    // lets go of the buffers, so the mesh doesn't have to copy them the next time it is written to:
+    m_lensSnapshot = MeshSnapshot();
+
+    // in the order of the rays, so the result doesn't depend on the threads:
+    m_hitFaces.clear();
+    for (std::size_t index = 0; index < m_rayPaths.size(); index++)
+    {
+        if (m_rayHits[index])
+        {
+            m_hitFaces.push_back(m_rayPaths[index].m_entryFace);
+            m_hitFaces.push_back(m_rayPaths[index].m_passFace);
+        }
     }
 }
 
+void ee::RayTracer::presentRays()
+{
+    for (std::size_t index = 0; index < m_rayPaths.size(); index++)
+    {
+        if (m_rayHits[index])
+        {
+            const LensRayPath& path = m_rayPaths[index];
+            m_drawableLines[index].m_airToCornea.setLine(path.m_airToCornea);
+            m_drawableLines[index].m_corneaToLens.setLine(path.m_corneaToLens);
+            m_drawableLines[index].m_inLens.setLine(path.m_inLens);
+            m_drawableLines[index].m_lensToCornea.setRay(path.m_end, 10.f);
+        }
+    }
+}
+
+void ee::RayTracer::traceBundle(const std::vector<Ray>& rays, std::vector<Ray>* const o_exitRays)
+{
+    const Mesh* const lensMesh = m_limitSurface ? m_limitSurface->getMesh() : m_lens.getMesh();
+    m_lensSnapshot = lensMesh->getSnapshot();
+    m_lensBVH.update(m_lensSnapshot);
+
+    o_exitRays->resize(rays.size());
+    parallelFor(0, rays.size(), [this, &rays, o_exitRays](const std::size_t index)
+    {
+        LensRayPath path;
+        (*o_exitRays)[index] = lensRefract(rays[index], &path, UINT_MAX) ? path.m_end : Ray();
+    }, RAY_GRAIN);
+
+    m_lensSnapshot = MeshSnapshot();
+}
+
 const std::vector<ee::Vec3>& ee::RayTracer::getResultColors() const
 {
     return m_resultColors;
 }
 
+const std::vector<std::size_t>& ee::RayTracer::getHitFaces() const
+{
+    return m_hitFaces;
+}
+
+void ee::RayTracer::setLimitSurface(const LimitSurface* const surface)
+{
+    m_limitSurface = surface;
+}
+
+void ee::RayTracer::setGradientIndex(const bool gradientIndex)
+{
+    m_gradientIndex = gradientIndex;
+}
+
 ee::RayTracer::RayTracer(std::vector<Vec3> positions, Lens sphere, RayTracerParam param) :
     m_parameters(param),
     m_lens(sphere),
+    m_limitSurface(nullptr),
+    m_gradientIndex(false),
     m_rayOrigins(positions)    
 {    
     m_resultColors.resize(m_rayOrigins.size());
@@ -36,7 +127,7 @@ ee::RayTracer::RayTracer(std::vector<Vec3> positions, Lens sphere, RayTracerPara
     assert(m_parameters.m_heightResolution > 0);
     assert(m_parameters.m_widthResolution > 0);
 
-    if ((sphere.getNumLongitudes() & 1) == 1)
+    if (sphere.getMesh()->getMeshType() == MeshType::UVSPHERE && (sphere.getNumLongitudes() & 1) == 1)
     {
         throw std::runtime_error("Lens UVSphere's number of longitudes must be even for the ray tracer.");
     }
@@ -65,6 +156,9 @@ ee::RayTracer::RayTracer(std::vector<Vec3> positions, Lens sphere, RayTracerPara
         m_drawableLines.push_back(DrawLensRayPath("lineTextPack"));
     }
 
+    m_rayPaths.resize(m_rayOrigins.size() * m_cachedPoints.size());
+    m_rayHits.resize(m_rayPaths.size(), 0);
+
     //for (int i = 0; i < 2 * m_cachedPoints.size(); i++)
     //{
     //    testNormals.push_back(new DrawLine("lineTextPack3", glm::vec3(), glm::vec3()));
@@ -81,7 +175,7 @@ ee::RayTracer::RayTracer(std::vector<Vec3> positions, Lens sphere, RayTracerPara
     }
 }
 
-bool ee::RayTracer::lensRefract(const Ray startRay, LensRayPath* o_rayPath, unsigned id)
+bool ee::RayTracer::lensRefract(const Ray startRay, LensRayPath* o_rayPath, unsigned id) const
 {
     LensRayPath result;
 
@@ -95,63 +189,76 @@ bool ee::RayTracer::lensRefract(const Ray startRay, LensRayPath* o_rayPath, unsi
         m_parameters.m_enviRefractiveIndex / m_parameters.m_eyeballRefractiveIndex));
 
     // now intersect this with the lens itself
-    const Mesh* const lensMesh = m_lens.getMesh();
     const Ray corneaToLens(corneaIntersection, airToCorneaRefraction);
 
-    const std::pair<std::size_t, Vec3> entryLensIntersection = nearestIntersectionMesh(lensMesh, corneaToLens);
-    // assert(entryIntersection.first < lensMesh->getNumMeshFaces());
-    if (entryLensIntersection.first >= lensMesh->getNumMeshFaces())
+    std::size_t entryFace;
+    Vec3 entryPoint, entryLensNormal;
+    if (!intersectLens(corneaToLens, ULONG_MAX, &entryFace, &entryPoint, &entryLensNormal, id))
     {
         return false;
     }
 
-    // get point of intersection:
-    const MeshFace& entryFace = lensMesh->getMeshFace(entryLensIntersection.first);
+    result.m_corneaToLens = Line(corneaToLens.m_origin, entryPoint);
+    result.m_entryFace = entryFace;
 
-    result.m_corneaToLens = Line(corneaToLens.m_origin, entryLensIntersection.second);
+    if (m_gradientIndex)
+    {
+        const GradientIndexField field(m_parameters.m_lensRefractiveIndex_middle, m_parameters.m_lensRefractiveIndex_end, m_lensSnapshot.m_invModelTrans);
+        const Vec3 entryLensRefraction = glm::normalize(cust::refract(corneaToLens.m_dir, entryLensNormal,
+            m_parameters.m_eyeballRefractiveIndex / field.getIndex(entryPoint)));
 
-    const Vec3 entryLensNormal = getNormal(entryLensIntersection.first, entryLensIntersection.second, id);
-    
-    Float radiusOfIntersection = glm::length(Vec2(entryLensIntersection.second.x, entryLensIntersection.second.y));
+        std::size_t passFace;
+        Vec3 passPoint, passLensNormal, passDir;
+        if (!marchLens(entryPoint, entryLensRefraction, entryFace, &passFace, &passPoint, &passLensNormal, &passDir)) { return false; }
+
+        // the drawn line is the chord of the curved path:
+        result.m_inLens = Line(entryPoint, passPoint);
+        result.m_passFace = passFace;
+        result.m_end = Ray(passPoint, glm::normalize(cust::refract(passDir, -passLensNormal, field.getIndex(passPoint) / m_parameters.m_eyeballRefractiveIndex)));
+
+        *o_rayPath = result;
+        return !glm::any(glm::isnan(result.m_end.m_dir)) && result.m_end.m_dir != Vec3();
+    }
+
+    Float radiusOfIntersection = glm::length(Vec2(entryPoint.x, entryPoint.y));
     Float actualLensRefrective = m_parameters.m_lensRefractiveIndex_end * (radiusOfIntersection)+m_parameters.m_lensRefractiveIndex_middle * (1.0 - radiusOfIntersection);
 
     const Vec3 entryLensRefraction = glm::normalize(cust::refract(corneaToLens.m_dir, entryLensNormal,
         m_parameters.m_eyeballRefractiveIndex / actualLensRefrective));
 
     // now let's find the next intersection:
-    const std::pair<std::size_t, Vec3> passIntersection = nearestIntersectionMesh(lensMesh, 
-        Ray(entryLensIntersection.second, entryLensRefraction), entryLensIntersection.first);
-    if (passIntersection.first >= lensMesh->getNumMeshFaces()) { return false; }
+    std::size_t passFace;
+    Vec3 passPoint, passLensNormal;
+    if (!intersectLens(Ray(entryPoint, entryLensRefraction), entryFace, &passFace, &passPoint, &passLensNormal, UINT_MAX)) { return false; }
 
     // assign the line:
-    result.m_inLens = Line(entryLensIntersection.second, passIntersection.second);
-
-
+    result.m_inLens = Line(entryPoint, passPoint);
+    result.m_passFace = passFace;
 
     // now calulcate the next part:
-    const MeshFace& passFace = lensMesh->getMeshFace(passIntersection.first);
-    const Vec3 passNormal = -getNormal(passIntersection.first, passIntersection.second, UINT_MAX);
+    const Vec3 passNormal = -passLensNormal;
     
-    const Vec3 passRefraction = glm::normalize(cust::refract(entryRefraction, passNormal, 1.f));
+    const Vec3 passRefraction = glm::normalize(cust::refract(entryLensRefraction, passNormal, 1.f));
 
     // now set the last part:
-    result.m_end = Ray(passIntersection.second, passRefraction);
+    result.m_end = Ray(passPoint, passRefraction);
 
     *o_rayPath = result;
     return result.m_end.m_dir != Vec3();
 }
 
-ee::Vec3 ee::RayTracer::getNormal(int triangle, Vec3 interPoint, unsigned id)
+ee::Vec3 ee::RayTracer::getNormal(int triangle, Vec3 interPoint, unsigned id) const
 {
-    Mesh* const lensMesh = m_lens.getMesh();
-    MeshFace face = lensMesh->getMeshFace(triangle);
-    Vertex vert0 = lensMesh->getTransformedVertex(face(0));
-    Vertex vert1 = lensMesh->getTransformedVertex(face(1));
-    Vertex vert2 = lensMesh->getTransformedVertex(face(2));
+    const MeshSnapshot& lensMesh = m_lensSnapshot;
+    const MeshFace& face = lensMesh.getMeshFace(triangle);
+    const Vertex& vert0 = lensMesh.getVertex(face(0));
+    const Vertex& vert1 = lensMesh.getVertex(face(1));
+    const Vertex& vert2 = lensMesh.getVertex(face(2));
 
+    // barycentric coordinates don't change under the model transform, so only the point and the normal are transformed:
     Float u, v, w;
-    baryCentric(interPoint, vert0.m_position, vert1.m_position, vert2.m_position, u, v, w);
-    Vec3 normal = glm::normalize(vert0.m_normal * u + vert1.m_normal * v + vert2.m_normal * w);
+    baryCentric(transPoint3(lensMesh.m_invModelTrans, interPoint), vert0.m_position, vert1.m_position, vert2.m_position, u, v, w);
+    Vec3 normal = glm::normalize(transVector3(lensMesh.m_normalModelTrans, vert0.m_normal * u + vert1.m_normal * v + vert2.m_normal * w));
     if (id != UINT_MAX)
     {
         //testNormals[id]->setRay(Ray(interPoint, normal), 10.0);
@@ -159,23 +266,124 @@ ee::Vec3 ee::RayTracer::getNormal(int triangle, Vec3 interPoint, unsigned id)
     return normal;
 }
 
-ee::Vec3 ee::RayTracer::raytrace(int pos, const Float rInc, const Float cInc)
+bool ee::RayTracer::marchLens(const Vec3 entryPoint, const Vec3 entryDir, const std::size_t entryFace,
+    std::size_t* const o_passFace, Vec3* const o_passPoint, Vec3* const o_passNormal, Vec3* const o_passDir) const
 {
-    for (std::size_t i = 0; i < m_rayOrigins.size(); i++)
+    const GradientIndexField field(m_parameters.m_lensRefractiveIndex_middle, m_parameters.m_lensRefractiveIndex_end, m_lensSnapshot.m_invModelTrans);
+
+    GradientIndexRay ray;
+    ray.m_position = entryPoint;
+    ray.m_optDir = field.getIndex(entryPoint) * entryDir;
+
+    // Cast the tangent of the ray to the surface and march to where it leaves the lens. The index falls off
+    // towards the surface, so the ray bends inwards and leaves the lens after its tangent does: the march
+    // stays inside and only needs another cast once it got as far as the tangent. Once going straight to
+    // the surface would be off by less than the tolerance, the last step ends the march there.
+    std::size_t ignore = entryFace;
+    Float dt = std::numeric_limits<Float>::max(); // the first step tries to go all the way
+    int steps = 0;
+    for (;;)
     {
-        for (std::size_t j = 0; j < m_cachedPoints.size(); j++)
+        const Vec3 dir = glm::normalize(ray.m_optDir);
+
+        // (a miss means that the march isn't inside the lens anymore)
+        std::size_t face;
+        Vec3 point, normal;
+        if (!intersectLens(Ray(ray.m_position, dir), ignore, &face, &point, &normal, UINT_MAX))
         {
-            const Ray currRay(Vec3(m_cachedPoints[j].x, m_cachedPoints[j].y, m_rayOrigins[i].z), Vec3(0.0, 0.0, 1.0)); // m_cachedPoints[j] - m_rayOrigins[i]);
-            LensRayPath path;
-            if (lensRefract(currRay, &path, j))
+            return false;
+        }
+
+        *o_passFace = face;
+        *o_passPoint = point;
+        *o_passNormal = normal;
+        *o_passDir = dir;
+        ignore = ULONG_MAX;
+
+        // on the surface, or out of steps (then the ray goes straight to the surface from where the march got to):
+        const Float surfaceDist = glm::length(point - ray.m_position);
+        if (surfaceDist <= GRIN_SURFACE_DIST || steps >= MAX_GRIN_STEPS)
+        {
+            return true;
+        }
+
+        const Float speed = glm::length(ray.m_optDir); // |dr/dt| = n
+        const bool lastStep = 0.5 * glm::length(field.calcRayCurvature(ray.m_position)) / (speed * speed) * surfaceDist * surfaceDist <= GRIN_TOLERANCE;
+
+        Float remaining = surfaceDist;
+        for (; steps < MAX_GRIN_STEPS; steps++)
+        {
+            const Float surfaceDt = remaining / glm::length(ray.m_optDir);
+            const bool toSurface = dt >= surfaceDt;
+            const Float stepDt = toSurface ? surfaceDt : dt;
+
+            Float error;
+            const GradientIndexRay next = stepCashKarp(field, ray, stepDt, &error);
+            if (error > GRIN_TOLERANCE && stepDt * glm::length(ray.m_optDir) > GRIN_MIN_STEP)
+            {
+                dt = stepDt * std::max(GRIN_MIN_SCALE, GRIN_SAFETY * std::pow(GRIN_TOLERANCE / error, 0.2));
+                continue;
+            }
+
+            if (toSurface && lastStep)
+            {
+                *o_passDir = glm::normalize(next.m_optDir);
+                return true;
+            }
+
+            remaining = std::max<Float>(0.0, remaining - glm::length(next.m_position - ray.m_position));
+            ray = next;
+            if (toSurface)
             {
-                std::size_t index = i * m_cachedPoints.size() + j;
-                m_drawableLines[index].m_begin.setLine(path.m_entry);
-                m_drawableLines[index].m_middle.setLine(path.m_pass);
-                m_drawableLines[index].m_end.setRay(path.m_end, 10.f);
+                steps++;
+                break;
             }
+            dt = stepDt * std::min(GRIN_MAX_SCALE, GRIN_SAFETY * std::pow(GRIN_TOLERANCE / std::max(error, GRIN_TOLERANCE * 1.0e-4), 0.2));
+        }
+    }
+}
+
+bool ee::RayTracer::intersectLens(const Ray ray, const std::size_t ignore, std::size_t* const o_face, Vec3* const o_point, Vec3* const o_normal, const unsigned id) const
+{
+    if (!m_limitSurface)
+    {
+        const std::pair<std::size_t, Vec3> intersection = m_lensBVH.nearestIntersection(ray, ignore);
+        if (intersection.first >= m_lensSnapshot.getNumMeshFaces())
+        {
+            return false;
         }
+
+        *o_face = intersection.first;
+        *o_point = intersection.second;
+        *o_normal = getNormal(intersection.first, intersection.second, id);
+        return true;
+    }
+
+    // start from the hit on the control mesh and refine it on the limit surface (in model space):
+    const MeshSnapshot& controlMesh = m_lensSnapshot;
+    const std::pair<std::size_t, Vec3> intersection = m_lensBVH.nearestIntersection(ray, ignore);
+    if (intersection.first >= controlMesh.getNumMeshFaces())
+    {
+        return false;
+    }
+
+    const Mat4& invModel = controlMesh.m_invModelTrans;
+    const Ray modelRay(transPoint3(invModel, ray.m_origin), transVector3(invModel, ray.m_dir));
+
+    const MeshFace& face = controlMesh.getMeshFace(intersection.first);
+    Float w, u, v;
+    baryCentric(transPoint3(invModel, intersection.second), controlMesh.getVertex(face(0)).m_position, controlMesh.getVertex(face(1)).m_position,
+        controlMesh.getVertex(face(2)).m_position, w, u, v);
+
+    LimitHit hit;
+    if (!m_limitSurface->intersect(controlMesh, modelRay, intersection.first, u, v, &hit))
+    {
+        return false;
     }
 
-    return Vec3(); // for now
+    // like Mesh::calcNormals, the normals face away from the center:
+    *o_face = hit.m_face;
+    *o_point = transPoint3(controlMesh.m_modelTrans, hit.m_position);
+    *o_normal = glm::normalize(transVector3(controlMesh.m_normalModelTrans, flipSameDir(hit.m_normal, hit.m_position)));
+    return true;
 }
\ No newline at end of file
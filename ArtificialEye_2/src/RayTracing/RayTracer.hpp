@@ -14,7 +14,10 @@
 #include "../Rendering/TexturePacks/LineUniColorTextPack.hpp"
 #include "../Rendering/Modeling/DrawLine.hpp"
 #include "../Rendering/Lens.hpp"
+#include "../Rendering/LimitSurface.hpp"
 #include "RTUtility.hpp"
+#include "MeshBVH.hpp"
+#include "GradientIndex.hpp"
 
 #undef min
 #undef max
@@ -37,9 +40,36 @@ namespace ee
     public:
         static RayTracer& initialize(std::vector<Vec3> positions, Lens sphere, RayTracerParam param);
 
+        // traceRays followed by presentRays
         void raytrace();
+
+        // Traces every ray (all the origins times all the points on the lens) in parallel into the ray paths,
+        // doesn't touch anything that is drawn.
+        void traceRays();
+
+        // Moves the drawn rays to the paths of the last traceRays (on the thread that owns the renderer), rays
+        // that missed keep their last path.
+        void presentRays();
+
+        // Traces any number of rays through the cornea and the lens in parallel (without drawing)
+        // and writes the ray that leaves the lens for every ray to o_exitRays. Rays that miss get a zero
+        // direction.
+        void traceBundle(const std::vector<Ray>& rays, std::vector<Ray>* o_exitRays);
+
         const std::vector<Vec3>& getResultColors() const;
 
+        // faces of the lens mesh that were hit during the last raytrace (unsorted, may hold duplicates),
+        // these are faces of the control mesh when tracing against the limit surface
+        const std::vector<std::size_t>& getHitFaces() const;
+
+        // Traces the lens against the exact limit surface of the control mesh instead of the (subdivided)
+        // lens mesh. The control mesh should have the same model transform, nullptr goes back to the mesh.
+        void setLimitSurface(const LimitSurface* surface);
+
+        // Marches the rays through the gradient index of the lens (see GradientIndexField) instead of going
+        // straight through it with a single index. Off by default.
+        void setGradientIndex(bool gradientIndex);
+
         void setCorneaSphere(Mat4 transform)
         {
             m_corneaSphere = transform;
@@ -75,6 +105,10 @@ namespace ee
             Line m_corneaToLens;
             Line m_inLens;
             Line m_lensToCornea;
+            Ray  m_end;
+
+            std::size_t m_entryFace;
+            std::size_t m_passFace;
         };
 
         std::pair<Float, Vec3> intersectCorneaSphere(Ray ray, Float min_dist) const
@@ -144,13 +178,26 @@ namespace ee
 
         RayTracer(std::vector<Vec3> positions, Lens sphere, RayTracerParam param);
 
-        Vec3       raytrace(int pos, Float rInc, Float cInc);
-        bool       lensRefract(Ray startRay, LensRayPath* o_rayPath, unsigned id); // TODO: remove "debug" ray id from the execution
-        Vec3       getNormal(int triangle, Vec3 interPoint, unsigned id);
+        // these only read the tracer, so any number of rays can be traced at the same time:
+        bool       lensRefract(Ray startRay, LensRayPath* o_rayPath, unsigned id) const; // TODO: remove "debug" ray id from the execution
+        Vec3       getNormal(int triangle, Vec3 interPoint, unsigned id) const;
+
+        // nearest intersection with the lens (or its limit surface), the normal faces out of the lens
+        bool       intersectLens(Ray ray, std::size_t ignore, std::size_t* o_face, Vec3* o_point, Vec3* o_normal, unsigned id) const;
+
+        // Follows the (curved) ray through the gradient index from the point it entered the lens at (in the
+        // refracted direction) to the point it leaves the lens at, o_passDir is the direction it leaves with.
+        // False if a cast from inside the lens misses it (the march ended up outside).
+        bool       marchLens(Vec3 entryPoint, Vec3 entryDir, std::size_t entryFace,
+                       std::size_t* o_passFace, Vec3* o_passPoint, Vec3* o_passNormal, Vec3* o_passDir) const;
 
         const RayTracerParam  m_parameters;
 
         Lens                  m_lens;
+        const LimitSurface*   m_limitSurface;
+        MeshBVH               m_lensBVH;        // over the lens mesh, or the control mesh of the limit surface
+        MeshSnapshot          m_lensSnapshot;   // of the same mesh, taken at the start of every trace
+        bool                  m_gradientIndex;
 
         Mat4                  m_corneaSphere;
         Mat4                  m_invCorneaSphere;
@@ -160,6 +207,11 @@ namespace ee
         std::vector<Vec3> m_cachedPoints;
 
         std::vector<Vec3>            m_resultColors; // the colors that will result
+        std::vector<std::size_t>     m_hitFaces;
+
+        // results of traceRays, ray i * m_cachedPoints.size() + j goes from origin i through point j:
+        std::vector<LensRayPath>     m_rayPaths;
+        std::vector<char>            m_rayHits;
         std::vector<DrawLensRayPath> m_drawableLines; // for rendering (these are all the rays to draw)
     };
 }
\ No newline at end of file
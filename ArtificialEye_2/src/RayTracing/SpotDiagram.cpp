@@ -0,0 +1,203 @@
+#include "SpotDiagram.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#undef min
+#undef max
+
+namespace
+{
+    // fixed, so the per chunk sums and bins are always merged the same way:
+    const std::size_t NUM_CHUNKS = 16;
+    const ee::Float   MIN_DIR_Z  = 1.0e-12;
+
+    const ee::Float GOLDEN_ANGLE = ee::PI * (3.0 - std::sqrt(5.0));
+}
+
+std::vector<ee::Ray> ee::makePupilRays(const Vec3 center, const Vec3 dir, const Float radius, const std::size_t numRays)
+{
+    const Vec3 forward = glm::normalize(dir);
+    const Vec3 side = glm::normalize(glm::cross(forward, std::abs(forward.x) < 0.9 ? Vec3(1.0, 0.0, 0.0) : Vec3(0.0, 1.0, 0.0)));
+    const Vec3 up = glm::cross(forward, side);
+
+    std::vector<Ray> rays(numRays);
+    parallelFor(0, numRays, [&](std::size_t i)
+    {
+        const Float r = radius * std::sqrt((i + 0.5) / numRays);
+        const Float angle = GOLDEN_ANGLE * i;
+        rays[i] = Ray(center + side * (r * std::cos(angle)) + up * (r * std::sin(angle)), forward);
+    }, 4096);
+
+    return rays;
+}
+
+ee::SpotDiagram::SpotDiagram(const unsigned resolution, const Float halfWidth, const unsigned numEnergyBins) :
+    m_resolution(std::max(1u, resolution)),
+    m_halfWidth(halfWidth),
+    m_numEnergyBins(std::max(1u, numEnergyBins)),
+    m_rmsRadius(0.0),
+    m_maxRadius(0.0),
+    m_energyRadiusStep(0.0),
+    m_chunkSpots(NUM_CHUNKS),
+    m_chunkSums(NUM_CHUNKS),
+    m_chunkPSF(NUM_CHUNKS, std::vector<unsigned>(m_resolution * m_resolution)),
+    m_chunkRadial(NUM_CHUNKS, std::vector<unsigned>(m_numEnergyBins))
+{
+}
+
+void ee::SpotDiagram::compute(const std::vector<Ray>& rays, const Float retinaZ)
+{
+    // intersect the retina and sum up the hits for the centroid:
+    // (fewer rays than chunks leave some of the chunks out)
+    std::fill(m_chunkSums.begin(), m_chunkSums.end(), ChunkSums());
+    for (std::vector<Vec2>& spots : m_chunkSpots)
+    {
+        spots.clear();
+    }
+    parallelForChunks(0, rays.size(), NUM_CHUNKS, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+    {
+        std::vector<Vec2>& spots = m_chunkSpots[chunk];
+        spots.reserve(end - begin);
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const Ray& ray = rays[i];
+            if (ray.m_dir.z <= MIN_DIR_Z)
+            {
+                continue;
+            }
+
+            const Float t = (retinaZ - ray.m_origin.z) / ray.m_dir.z;
+            if (t < 0.0)
+            {
+                continue;
+            }
+
+            const Vec2 spot(ray.m_origin.x + ray.m_dir.x * t, ray.m_origin.y + ray.m_dir.y * t);
+            spots.push_back(spot);
+            m_chunkSums[chunk].m_sum0 += spot.x;
+            m_chunkSums[chunk].m_sum1 += spot.y;
+        }
+    });
+
+    m_spots.clear();
+    Vec2 sum;
+    for (std::size_t chunk = 0; chunk < NUM_CHUNKS; chunk++)
+    {
+        m_spots.insert(m_spots.end(), m_chunkSpots[chunk].begin(), m_chunkSpots[chunk].end());
+        sum += Vec2(m_chunkSums[chunk].m_sum0, m_chunkSums[chunk].m_sum1);
+    }
+
+    const std::size_t numSpots = m_spots.size();
+    m_psf.assign(m_resolution * m_resolution, 0.0);
+    m_encircledEnergy.assign(m_numEnergyBins, 1.0);
+    m_energyRadiusStep = 0.0;
+    if (numSpots == 0)
+    {
+        m_centroid = Vec2();
+        m_rmsRadius = 0.0;
+        m_maxRadius = 0.0;
+        m_encircledEnergy.assign(m_numEnergyBins, 0.0);
+        return;
+    }
+    m_centroid = sum / static_cast<Float>(numSpots);
+
+    // spread around the centroid and the PSF histogram:
+    const Float pixelScale = m_resolution / (2.0 * m_halfWidth);
+    const Vec2 psfMin = m_centroid - Vec2(m_halfWidth);
+    std::fill(m_chunkSums.begin(), m_chunkSums.end(), ChunkSums());
+    for (std::vector<unsigned>& psf : m_chunkPSF)
+    {
+        std::fill(psf.begin(), psf.end(), 0);
+    }
+    parallelForChunks(0, numSpots, NUM_CHUNKS, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+    {
+        std::vector<unsigned>& psf = m_chunkPSF[chunk];
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const Vec2 offset = m_spots[i] - m_centroid;
+            const Float sqrRadius = glm::dot(offset, offset);
+            m_chunkSums[chunk].m_sum0 += sqrRadius;
+            m_chunkSums[chunk].m_max = std::max(m_chunkSums[chunk].m_max, sqrRadius);
+
+            const Vec2 pixel = (m_spots[i] - psfMin) * pixelScale;
+            if (pixel.x >= 0.0 && pixel.y >= 0.0 && pixel.x < m_resolution && pixel.y < m_resolution)
+            {
+                psf[static_cast<unsigned>(pixel.y) * m_resolution + static_cast<unsigned>(pixel.x)]++;
+            }
+        }
+    });
+
+    Float sumSqrRadius = 0.0;
+    Float maxSqrRadius = 0.0;
+    for (std::size_t chunk = 0; chunk < NUM_CHUNKS; chunk++)
+    {
+        sumSqrRadius += m_chunkSums[chunk].m_sum0;
+        maxSqrRadius = std::max(maxSqrRadius, m_chunkSums[chunk].m_max);
+    }
+
+    // the chunks are added up in order, the counts are exact:
+    m_rmsRadius = std::sqrt(sumSqrRadius / numSpots);
+    m_maxRadius = std::sqrt(maxSqrRadius);
+    for (std::size_t p = 0; p < m_psf.size(); p++)
+    {
+        unsigned count = 0;
+        for (std::size_t chunk = 0; chunk < NUM_CHUNKS; chunk++)
+        {
+            count += m_chunkPSF[chunk][p];
+        }
+        m_psf[p] = static_cast<Float>(count) / numSpots;
+    }
+
+    if (m_maxRadius <= 0.0)
+    {
+        // every ray hit the same point, all of the energy is in the first bin
+        return;
+    }
+
+    // the radial histogram for the encircled energy, the last bin ends at the spot furthest out:
+    m_energyRadiusStep = m_maxRadius / m_numEnergyBins;
+    for (std::vector<unsigned>& radial : m_chunkRadial)
+    {
+        std::fill(radial.begin(), radial.end(), 0);
+    }
+    parallelForChunks(0, numSpots, NUM_CHUNKS, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+    {
+        std::vector<unsigned>& radial = m_chunkRadial[chunk];
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const Float radius = glm::length(m_spots[i] - m_centroid);
+            radial[std::min(m_numEnergyBins - 1, static_cast<unsigned>(radius / m_energyRadiusStep))]++;
+        }
+    });
+
+    std::size_t encircled = 0;
+    for (unsigned bin = 0; bin < m_numEnergyBins; bin++)
+    {
+        for (std::size_t chunk = 0; chunk < NUM_CHUNKS; chunk++)
+        {
+            encircled += m_chunkRadial[chunk][bin];
+        }
+        m_encircledEnergy[bin] = static_cast<Float>(encircled) / numSpots;
+    }
+}
+
+ee::Float ee::SpotDiagram::calcEncircledRadius(const Float fraction) const
+{
+    Float prevEnergy = 0.0;
+    for (std::size_t bin = 0; bin < m_encircledEnergy.size(); bin++)
+    {
+        if (m_encircledEnergy[bin] >= fraction)
+        {
+            // linear within the bin:
+            const Float binEnergy = m_encircledEnergy[bin] - prevEnergy;
+            const Float inBin = binEnergy > 0.0 ? (fraction - prevEnergy) / binEnergy : 1.0;
+            return (bin + std::max<Float>(0.0, inBin)) * m_energyRadiusStep;
+        }
+        prevEnergy = m_encircledEnergy[bin];
+    }
+
+    return m_maxRadius;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../Types.hpp"
+
+namespace ee
+{
+    // numRays parallel rays through a disc of the given radius around center (perpendicular to dir), spread
+    // evenly over its area on a Fermat spiral. The same number of rays always gives the same rays.
+    std::vector<Ray> makePupilRays(Vec3 center, Vec3 dir, Float radius, std::size_t numRays);
+
+    // Where the rays that left the lens hit the retina, the plane z = retinaZ (the rays travel towards +z),
+    // and what that image looks like: centroid, RMS radius, encircled energy and the point spread function
+    // (a histogram of the hits around the centroid). The work is split into a fixed number of chunks with
+    // their own bins and sums, merged in chunk order, so the results don't depend on the number of threads.
+    // The bins are kept between calls, only the spots grow with the number of rays.
+    class SpotDiagram
+    {
+    public:
+        // the PSF has resolution x resolution pixels and covers the centroid +- halfWidth on both axes
+        SpotDiagram(unsigned resolution, Float halfWidth, unsigned numEnergyBins = 100);
+
+        void compute(const std::vector<Ray>& rays, Float retinaZ);
+
+        // hits on the retina (x, y) in the order of the rays, rays that don't reach it are left out
+        const std::vector<Vec2>& getSpots() const { return m_spots; }
+        std::size_t getNumSpots() const { return m_spots.size(); }
+
+        Vec2 getCentroid() const { return m_centroid; }
+        Float getRMSRadius() const { return m_rmsRadius; }
+        Float getMaxRadius() const { return m_maxRadius; }
+
+        // fraction of the spots within (i + 1) * getEnergyRadiusStep() of the centroid
+        const std::vector<Float>& getEncircledEnergy() const { return m_encircledEnergy; }
+        Float getEnergyRadiusStep() const { return m_energyRadiusStep; }
+
+        // radius around the centroid that holds the fraction of the spots (like 0.8 for EE80)
+        Float calcEncircledRadius(Float fraction) const;
+
+        // row major (y rows, x columns), every pixel is the fraction of all the spots that fell into it
+        const std::vector<Float>& getPSF() const { return m_psf; }
+        unsigned getResolution() const { return m_resolution; }
+        Float getHalfWidth() const { return m_halfWidth; }
+        Float getPixelSize() const { return 2.0 * m_halfWidth / m_resolution; }
+
+    private:
+        struct ChunkSums
+        {
+            Float m_sum0;
+            Float m_sum1;
+            Float m_max;
+        };
+
+        const unsigned m_resolution;
+        const Float    m_halfWidth;
+        const unsigned m_numEnergyBins;
+
+        std::vector<Vec2>  m_spots;
+        Vec2               m_centroid;
+        Float              m_rmsRadius;
+        Float              m_maxRadius;
+        std::vector<Float> m_encircledEnergy;
+        Float              m_energyRadiusStep;
+        std::vector<Float> m_psf;
+
+        // per chunk:
+        std::vector<std::vector<Vec2>>      m_chunkSpots;
+        std::vector<ChunkSums>              m_chunkSums;
+        std::vector<std::vector<unsigned>>  m_chunkPSF;
+        std::vector<std::vector<unsigned>>  m_chunkRadial;
+    };
+}
\ No newline at end of file
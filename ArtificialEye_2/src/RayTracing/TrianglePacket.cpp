@@ -0,0 +1,269 @@
+#include "TrianglePacket.hpp"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define EE_SIMD_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define EE_TARGET_AVX
+#else
+#include <cpuid.h>
+#define EE_TARGET_AVX __attribute__((target("avx"))) // only this function may use AVX, the rest has to run anywhere
+#endif
+#endif
+
+namespace
+{
+    typedef void (*IntersectPacketFunc)(const ee::Ray& ray, const ee::TrianglePacket& packet, ee::Float* o_dist);
+
+    const ee::Float EPS = glm::epsilon<ee::Float>(); // the same as intersectTriangle
+
+    // Same operations in the same order as intersectTriangle, so the SIMD versions give the same bits:
+    //  h = d x e1, a = e0 . h, f = 1 / a, s = o - p0, u = f (s . h), q = s x e0, v = f (d . q), t = f (e1 . q)
+    void intersectScalar(const ee::Ray& ray, const ee::TrianglePacket& packet, ee::Float* const o_dist)
+    {
+        for (std::size_t lane = 0; lane < ee::TRIANGLE_PACKET_SIZE; lane++)
+        {
+            const ee::Vec3 p0(packet.m_p0[0][lane], packet.m_p0[1][lane], packet.m_p0[2][lane]);
+            const ee::Vec3 edge0(packet.m_edge0[0][lane], packet.m_edge0[1][lane], packet.m_edge0[2][lane]);
+            const ee::Vec3 edge1(packet.m_edge1[0][lane], packet.m_edge1[1][lane], packet.m_edge1[2][lane]);
+
+            o_dist[lane] = 0.0;
+
+            const ee::Vec3 h = glm::cross(ray.m_dir, edge1);
+            const ee::Float a = glm::dot(edge0, h);
+            if (std::abs(a) < EPS)
+            {
+                continue;
+            }
+
+            const ee::Float f = 1.0 / a;
+            const ee::Vec3 s = ray.m_origin - p0;
+            const ee::Float u = f * glm::dot(s, h);
+            if (u < 0.0 || u > 1.0)
+            {
+                continue;
+            }
+
+            const ee::Vec3 q = glm::cross(s, edge0);
+            const ee::Float v = f * glm::dot(ray.m_dir, q);
+            if (v < 0.0 || u + v > 1.0)
+            {
+                continue;
+            }
+
+            const ee::Float t = f * glm::dot(edge1, q);
+            o_dist[lane] = t > EPS ? t : 0.0;
+        }
+    }
+
+#ifdef EE_SIMD_X86
+    // two triangles per register, so the packet takes two passes:
+    void intersectSSE2(const ee::Ray& ray, const ee::TrianglePacket& packet, ee::Float* const o_dist)
+    {
+        const __m128d eps = _mm_set1_pd(EPS);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d signMask = _mm_set1_pd(-0.0);
+
+        const __m128d dx = _mm_set1_pd(ray.m_dir.x);
+        const __m128d dy = _mm_set1_pd(ray.m_dir.y);
+        const __m128d dz = _mm_set1_pd(ray.m_dir.z);
+        const __m128d ox = _mm_set1_pd(ray.m_origin.x);
+        const __m128d oy = _mm_set1_pd(ray.m_origin.y);
+        const __m128d oz = _mm_set1_pd(ray.m_origin.z);
+
+        for (std::size_t lane = 0; lane < ee::TRIANGLE_PACKET_SIZE; lane += 2)
+        {
+            const __m128d e0x = _mm_loadu_pd(&packet.m_edge0[0][lane]);
+            const __m128d e0y = _mm_loadu_pd(&packet.m_edge0[1][lane]);
+            const __m128d e0z = _mm_loadu_pd(&packet.m_edge0[2][lane]);
+            const __m128d e1x = _mm_loadu_pd(&packet.m_edge1[0][lane]);
+            const __m128d e1y = _mm_loadu_pd(&packet.m_edge1[1][lane]);
+            const __m128d e1z = _mm_loadu_pd(&packet.m_edge1[2][lane]);
+
+            const __m128d hx = _mm_sub_pd(_mm_mul_pd(dy, e1z), _mm_mul_pd(e1y, dz));
+            const __m128d hy = _mm_sub_pd(_mm_mul_pd(dz, e1x), _mm_mul_pd(e1z, dx));
+            const __m128d hz = _mm_sub_pd(_mm_mul_pd(dx, e1y), _mm_mul_pd(e1x, dy));
+            const __m128d a = _mm_add_pd(_mm_add_pd(_mm_mul_pd(e0x, hx), _mm_mul_pd(e0y, hy)), _mm_mul_pd(e0z, hz));
+            __m128d valid = _mm_cmpge_pd(_mm_andnot_pd(signMask, a), eps);
+
+            const __m128d f = _mm_div_pd(one, a);
+            const __m128d sx = _mm_sub_pd(ox, _mm_loadu_pd(&packet.m_p0[0][lane]));
+            const __m128d sy = _mm_sub_pd(oy, _mm_loadu_pd(&packet.m_p0[1][lane]));
+            const __m128d sz = _mm_sub_pd(oz, _mm_loadu_pd(&packet.m_p0[2][lane]));
+            const __m128d u = _mm_mul_pd(f, _mm_add_pd(_mm_add_pd(_mm_mul_pd(sx, hx), _mm_mul_pd(sy, hy)), _mm_mul_pd(sz, hz)));
+            valid = _mm_and_pd(valid, _mm_and_pd(_mm_cmpge_pd(u, zero), _mm_cmple_pd(u, one)));
+
+            const __m128d qx = _mm_sub_pd(_mm_mul_pd(sy, e0z), _mm_mul_pd(e0y, sz));
+            const __m128d qy = _mm_sub_pd(_mm_mul_pd(sz, e0x), _mm_mul_pd(e0z, sx));
+            const __m128d qz = _mm_sub_pd(_mm_mul_pd(sx, e0y), _mm_mul_pd(e0x, sy));
+            const __m128d v = _mm_mul_pd(f, _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, qx), _mm_mul_pd(dy, qy)), _mm_mul_pd(dz, qz)));
+            valid = _mm_and_pd(valid, _mm_and_pd(_mm_cmpge_pd(v, zero), _mm_cmple_pd(_mm_add_pd(u, v), one)));
+
+            const __m128d t = _mm_mul_pd(f, _mm_add_pd(_mm_add_pd(_mm_mul_pd(e1x, qx), _mm_mul_pd(e1y, qy)), _mm_mul_pd(e1z, qz)));
+            valid = _mm_and_pd(valid, _mm_cmpgt_pd(t, eps));
+
+            _mm_storeu_pd(&o_dist[lane], _mm_and_pd(valid, t));
+        }
+    }
+
+    // the whole packet in one pass (plain AVX is enough for doubles, no FMA so the rounding stays the same):
+    EE_TARGET_AVX void intersectAVX(const ee::Ray& ray, const ee::TrianglePacket& packet, ee::Float* const o_dist)
+    {
+        const __m256d eps = _mm256_set1_pd(EPS);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+
+        const __m256d dx = _mm256_set1_pd(ray.m_dir.x);
+        const __m256d dy = _mm256_set1_pd(ray.m_dir.y);
+        const __m256d dz = _mm256_set1_pd(ray.m_dir.z);
+
+        const __m256d e0x = _mm256_loadu_pd(packet.m_edge0[0]);
+        const __m256d e0y = _mm256_loadu_pd(packet.m_edge0[1]);
+        const __m256d e0z = _mm256_loadu_pd(packet.m_edge0[2]);
+        const __m256d e1x = _mm256_loadu_pd(packet.m_edge1[0]);
+        const __m256d e1y = _mm256_loadu_pd(packet.m_edge1[1]);
+        const __m256d e1z = _mm256_loadu_pd(packet.m_edge1[2]);
+
+        const __m256d hx = _mm256_sub_pd(_mm256_mul_pd(dy, e1z), _mm256_mul_pd(e1y, dz));
+        const __m256d hy = _mm256_sub_pd(_mm256_mul_pd(dz, e1x), _mm256_mul_pd(e1z, dx));
+        const __m256d hz = _mm256_sub_pd(_mm256_mul_pd(dx, e1y), _mm256_mul_pd(e1x, dy));
+        const __m256d a = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e0x, hx), _mm256_mul_pd(e0y, hy)), _mm256_mul_pd(e0z, hz));
+        __m256d valid = _mm256_cmp_pd(_mm256_andnot_pd(signMask, a), eps, _CMP_GE_OQ);
+
+        const __m256d f = _mm256_div_pd(one, a);
+        const __m256d sx = _mm256_sub_pd(_mm256_set1_pd(ray.m_origin.x), _mm256_loadu_pd(packet.m_p0[0]));
+        const __m256d sy = _mm256_sub_pd(_mm256_set1_pd(ray.m_origin.y), _mm256_loadu_pd(packet.m_p0[1]));
+        const __m256d sz = _mm256_sub_pd(_mm256_set1_pd(ray.m_origin.z), _mm256_loadu_pd(packet.m_p0[2]));
+        const __m256d u = _mm256_mul_pd(f, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(sx, hx), _mm256_mul_pd(sy, hy)), _mm256_mul_pd(sz, hz)));
+        valid = _mm256_and_pd(valid, _mm256_and_pd(_mm256_cmp_pd(u, zero, _CMP_GE_OQ), _mm256_cmp_pd(u, one, _CMP_LE_OQ)));
+
+        const __m256d qx = _mm256_sub_pd(_mm256_mul_pd(sy, e0z), _mm256_mul_pd(e0y, sz));
+        const __m256d qy = _mm256_sub_pd(_mm256_mul_pd(sz, e0x), _mm256_mul_pd(e0z, sx));
+        const __m256d qz = _mm256_sub_pd(_mm256_mul_pd(sx, e0y), _mm256_mul_pd(e0x, sy));
+        const __m256d v = _mm256_mul_pd(f, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, qx), _mm256_mul_pd(dy, qy)), _mm256_mul_pd(dz, qz)));
+        valid = _mm256_and_pd(valid, _mm256_and_pd(_mm256_cmp_pd(v, zero, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_add_pd(u, v), one, _CMP_LE_OQ)));
+
+        const __m256d t = _mm256_mul_pd(f, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e1x, qx), _mm256_mul_pd(e1y, qy)), _mm256_mul_pd(e1z, qz)));
+        valid = _mm256_and_pd(valid, _mm256_cmp_pd(t, eps, _CMP_GT_OQ));
+
+        _mm256_storeu_pd(o_dist, _mm256_and_pd(valid, t));
+    }
+
+    void cpuid(const int leaf, int o_info[4])
+    {
+#ifdef _MSC_VER
+        __cpuid(o_info, leaf);
+#else
+        unsigned a, b, c, d;
+        __cpuid(leaf, a, b, c, d);
+        o_info[0] = static_cast<int>(a);
+        o_info[1] = static_cast<int>(b);
+        o_info[2] = static_cast<int>(c);
+        o_info[3] = static_cast<int>(d);
+#endif
+    }
+
+    // the register state the operating system saves on a context switch
+    uint64_t getEnabledXStates()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t low, high;
+        __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+    }
+#endif
+
+    ee::SimdLevel detectSimdLevel()
+    {
+#ifdef EE_SIMD_X86
+        int info[4];
+        cpuid(0, info);
+        if (info[0] < 1)
+        {
+            return ee::SimdLevel::SCALAR;
+        }
+
+        cpuid(1, info);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX also needs the operating system to save the upper halves of the registers (xmm and ymm state):
+        if (sse2 && osxsave && avx && (getEnabledXStates() & 0x6) == 0x6)
+        {
+            return ee::SimdLevel::AVX;
+        }
+        return sse2 ? ee::SimdLevel::SSE2 : ee::SimdLevel::SCALAR;
+#else
+        return ee::SimdLevel::SCALAR;
+#endif
+    }
+
+    IntersectPacketFunc selectIntersectPacket(const ee::SimdLevel level)
+    {
+#ifdef EE_SIMD_X86
+        switch (level)
+        {
+        case ee::SimdLevel::AVX:
+            return &intersectAVX;
+        case ee::SimdLevel::SSE2:
+            return &intersectSSE2;
+        default:
+            break;
+        }
+#endif
+        return &intersectScalar;
+    }
+
+    const ee::SimdLevel g_supportedLevel = detectSimdLevel();
+    ee::SimdLevel g_level = g_supportedLevel;
+    IntersectPacketFunc g_intersectPacket = selectIntersectPacket(g_supportedLevel);
+}
+
+void ee::setPacketTriangle(TrianglePacket* const io_packet, const std::size_t lane, const Vec3& p0, const Vec3& p1, const Vec3& p2)
+{
+    const Vec3 edge0 = p1 - p0;
+    const Vec3 edge1 = p2 - p0;
+    for (int k = 0; k < 3; k++)
+    {
+        io_packet->m_p0[k][lane] = p0[k];
+        io_packet->m_edge0[k][lane] = edge0[k];
+        io_packet->m_edge1[k][lane] = edge1[k];
+    }
+}
+
+void ee::clearPacketTriangle(TrianglePacket* const io_packet, const std::size_t lane)
+{
+    setPacketTriangle(io_packet, lane, Vec3(), Vec3(), Vec3());
+}
+
+ee::SimdLevel ee::getSupportedSimdLevel()
+{
+    return g_supportedLevel;
+}
+
+ee::SimdLevel ee::getSimdLevel()
+{
+    return g_level;
+}
+
+void ee::setSimdLevel(const SimdLevel level)
+{
+    g_level = static_cast<int>(level) < static_cast<int>(g_supportedLevel) ? level : g_supportedLevel;
+    g_intersectPacket = selectIntersectPacket(g_level);
+}
+
+void ee::intersectTrianglePacket(const Ray& ray, const TrianglePacket& packet, Float o_dist[TRIANGLE_PACKET_SIZE])
+{
+    g_intersectPacket(ray, packet, o_dist);
+}
\ No newline at end of file
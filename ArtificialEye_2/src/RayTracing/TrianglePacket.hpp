@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../Types.hpp"
+
+namespace ee
+{
+    const std::size_t TRIANGLE_PACKET_SIZE = 4;
+
+    // Four triangles in structure of arrays layout (one array per component), the way the SIMD intersection
+    // reads them. Lanes that aren't used are degenerate and never hit.
+    struct TrianglePacket
+    {
+        Float m_p0[3][TRIANGLE_PACKET_SIZE];
+        Float m_edge0[3][TRIANGLE_PACKET_SIZE];  // p1 - p0
+        Float m_edge1[3][TRIANGLE_PACKET_SIZE];  // p2 - p0
+    };
+
+    void setPacketTriangle(TrianglePacket* io_packet, std::size_t lane, const Vec3& p0, const Vec3& p1, const Vec3& p2);
+    void clearPacketTriangle(TrianglePacket* io_packet, std::size_t lane);
+
+    enum class SimdLevel
+    {
+        SCALAR,
+        SSE2,
+        AVX
+    };
+
+    // the best level the processor (and the operating system) supports, found with cpuid once at startup
+    SimdLevel getSupportedSimdLevel();
+
+    // the level intersectTrianglePacket uses, lower it to compare results and timings (it can't go above the
+    // supported level)
+    SimdLevel getSimdLevel();
+    void setSimdLevel(SimdLevel level);
+
+    // Intersects the ray with every triangle of the packet and writes the distance along the ray of each hit
+    // (0 if there is none). Same test and results as intersectTriangle, for four triangles at a time.
+    void intersectTrianglePacket(const Ray& ray, const TrianglePacket& packet, Float o_dist[TRIANGLE_PACKET_SIZE]);
+}
\ No newline at end of file
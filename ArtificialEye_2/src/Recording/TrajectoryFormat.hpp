@@ -0,0 +1,146 @@
+#pragma once
+
+#include "../Types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace ee
+{
+    // Layout of a trajectory file (all values little endian):
+    //
+    //  header:  magic[8] | version u32 | numVertices u32 | numTargets u32 | keyframeInterval u32 | quantStep f64
+    //  frames:  flags u8 | time f64 | volume f64 | pressure f64 | payloadSize u32 | payload
+    //  index:   numFrames u64 | (offset u64, time f64) * numFrames
+    //  trailer: indexOffset u64 | magic[8]
+    //
+    // The payload holds the quantized vertex positions followed by the quantized constraint targets.
+    // Keyframes store absolute values, every other frame stores the difference to the previous frame
+    // moved on by the motion since the frame before that, which is only a few quantization steps for
+    // the smooth lens trajectories. The motion starts at 0 on every keyframe, so a reader can seek to
+    // any frame by decoding from the nearest keyframe before it. The zig-zag encoded values are packed
+    // in blocks of TRAJ_BLOCK_SIZE: bit width u8 | the values with that many bits each, LSB first.
+    //
+    // Version 1 files have no motion and one zig-zag varint per value, they can still be read.
+
+    const char     TRAJ_FILE_MAGIC[8]   = { 'A', 'E', 'T', 'R', 'A', 'J', '0', '1' };
+    const char     TRAJ_INDEX_MAGIC[8]  = { 'A', 'E', 'T', 'I', 'N', 'D', 'E', 'X' };
+    const uint32_t TRAJ_VERSION         = 2;
+    const uint8_t  TRAJ_FLAG_KEYFRAME   = 1;
+    const unsigned TRAJ_BLOCK_SIZE      = 32;
+
+    struct TrajectoryFrame
+    {
+        Float               m_time;
+        Float               m_volume;
+        Float               m_pressure;
+        std::vector<Vec3>   m_positions;
+        std::vector<Vec3>   m_targets;
+
+        TrajectoryFrame() : m_time(0.0), m_volume(0.0), m_pressure(0.0) {}
+    };
+
+    namespace traj
+    {
+        inline uint64_t zigZagEncode(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t zigZagDecode(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        inline void writeVarint(uint64_t value, std::vector<uint8_t>* o_buffer)
+        {
+            while (value >= 0x80)
+            {
+                o_buffer->push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            o_buffer->push_back(static_cast<uint8_t>(value));
+        }
+
+        // returns false if the buffer ran out before the varint ended
+        inline bool readVarint(const uint8_t*& io_ptr, const uint8_t* end, uint64_t* o_value)
+        {
+            uint64_t result = 0;
+            for (unsigned shift = 0; io_ptr < end && shift < 64; shift += 7)
+            {
+                const uint8_t byte = *io_ptr++;
+                result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    *o_value = result;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // count <= TRAJ_BLOCK_SIZE values with the smallest bit width that fits all of them
+        inline void writeBlock(const uint64_t* values, std::size_t count, std::vector<uint8_t>* o_buffer)
+        {
+            uint64_t bits = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                bits |= values[i];
+            }
+            unsigned width = 0;
+            while (width < 64 && (bits >> width) != 0)
+            {
+                width++;
+            }
+
+            o_buffer->push_back(static_cast<uint8_t>(width));
+            uint64_t pending = 0;
+            unsigned numPending = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                for (unsigned bit = 0; bit < width; bit++)
+                {
+                    pending |= ((values[i] >> bit) & 1) << numPending;
+                    if (++numPending == 8)
+                    {
+                        o_buffer->push_back(static_cast<uint8_t>(pending));
+                        pending = 0;
+                        numPending = 0;
+                    }
+                }
+            }
+            if (numPending > 0)
+            {
+                o_buffer->push_back(static_cast<uint8_t>(pending));
+            }
+        }
+
+        // returns false if the buffer ran out before the block ended
+        inline bool readBlock(const uint8_t*& io_ptr, const uint8_t* end, std::size_t count, uint64_t* o_values)
+        {
+            if (io_ptr >= end || *io_ptr > 64)
+            {
+                return false;
+            }
+            const unsigned width = *io_ptr++;
+            const std::size_t numBytes = (count * width + 7) / 8;
+            if (static_cast<std::size_t>(end - io_ptr) < numBytes)
+            {
+                return false;
+            }
+
+            std::size_t bitPos = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                uint64_t value = 0;
+                for (unsigned bit = 0; bit < width; bit++, bitPos++)
+                {
+                    value |= static_cast<uint64_t>((io_ptr[bitPos / 8] >> (bitPos % 8)) & 1) << bit;
+                }
+                o_values[i] = value;
+            }
+            io_ptr += numBytes;
+            return true;
+        }
+    }
+}
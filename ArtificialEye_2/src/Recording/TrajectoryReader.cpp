@@ -0,0 +1,265 @@
+#include "TrajectoryReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    const std::size_t HEADER_SIZE       = 8 + 4 * sizeof(uint32_t) + sizeof(double);
+    const std::size_t FRAME_HEADER_SIZE = sizeof(uint8_t) + 3 * sizeof(double) + sizeof(uint32_t);
+    const std::size_t TRAILER_SIZE      = sizeof(uint64_t) + 8;
+
+    template<typename T>
+    bool readRaw(std::ifstream& file, T* o_value)
+    {
+        file.read(reinterpret_cast<char*>(o_value), sizeof(T));
+        return file.good();
+    }
+}
+
+ee::TrajectoryReader::TrajectoryReader(const std::string& file) :
+    m_file(file, std::ios::binary),
+    m_decodedFrame(std::numeric_limits<std::size_t>::max())
+{
+    if (!m_file.is_open())
+    {
+        throw std::runtime_error("Could not open trajectory file " + file + ".");
+    }
+
+    char magic[8];
+    uint32_t version, numVertices, numTargets, keyframeInterval;
+    double quantStep;
+    m_file.read(magic, sizeof(magic));
+    if (!m_file.good() || std::memcmp(magic, TRAJ_FILE_MAGIC, sizeof(magic)) != 0 ||
+        !readRaw(m_file, &version) || !readRaw(m_file, &numVertices) || !readRaw(m_file, &numTargets) ||
+        !readRaw(m_file, &keyframeInterval) || !readRaw(m_file, &quantStep))
+    {
+        throw std::runtime_error(file + " is not a trajectory file.");
+    }
+
+    if (version < 1 || version > TRAJ_VERSION)
+    {
+        throw std::runtime_error(file + " was written with an unsupported trajectory version.");
+    }
+
+    // every frame is decoded from the keyframe before it:
+    if (keyframeInterval == 0)
+    {
+        throw std::runtime_error(file + " has a keyframe interval of 0.");
+    }
+
+    m_numVertices = numVertices;
+    m_numTargets = numTargets;
+    m_keyframeInterval = keyframeInterval;
+    m_quantStep = quantStep;
+    m_version = version;
+
+    m_positions.resize(3 * m_numVertices);
+    m_targets.resize(3 * m_numTargets);
+    m_positionMotion.resize(3 * m_numVertices);
+    m_targetMotion.resize(3 * m_numTargets);
+    m_encoded.resize(3 * (m_numVertices + m_numTargets));
+
+    // read the index from the trailer, if the recording was never closed properly we scan the frames instead:
+    m_file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+
+    bool hasIndex = false;
+    if (fileSize >= HEADER_SIZE + TRAILER_SIZE)
+    {
+        uint64_t indexOffset;
+        m_file.seekg(fileSize - TRAILER_SIZE);
+        if (readRaw(m_file, &indexOffset) && m_file.read(magic, sizeof(magic)) &&
+            std::memcmp(magic, TRAJ_INDEX_MAGIC, sizeof(magic)) == 0 && indexOffset < fileSize)
+        {
+            uint64_t numFrames;
+            m_file.seekg(indexOffset);
+            if (readRaw(m_file, &numFrames))
+            {
+                m_offsets.resize(static_cast<std::size_t>(numFrames));
+                m_times.resize(static_cast<std::size_t>(numFrames));
+                hasIndex = true;
+                for (std::size_t i = 0; i < m_offsets.size() && hasIndex; i++)
+                {
+                    double time;
+                    hasIndex = readRaw(m_file, &m_offsets[i]) && readRaw(m_file, &time);
+                    m_times[i] = time;
+                }
+            }
+        }
+    }
+
+    if (!hasIndex)
+    {
+        m_file.clear();
+        rebuildIndex(fileSize);
+    }
+}
+
+std::size_t ee::TrajectoryReader::getNumFrames() const
+{
+    return m_offsets.size();
+}
+
+std::size_t ee::TrajectoryReader::getNumVertices() const
+{
+    return m_numVertices;
+}
+
+std::size_t ee::TrajectoryReader::getNumTargets() const
+{
+    return m_numTargets;
+}
+
+ee::Float ee::TrajectoryReader::getQuantizationStep() const
+{
+    return m_quantStep;
+}
+
+ee::Float ee::TrajectoryReader::getFrameTime(const std::size_t frameID) const
+{
+    return m_times[frameID];
+}
+
+std::size_t ee::TrajectoryReader::findFrame(const Float time) const
+{
+    auto it = std::upper_bound(m_times.begin(), m_times.end(), time);
+    return it == m_times.begin() ? 0 : static_cast<std::size_t>(it - m_times.begin()) - 1;
+}
+
+void ee::TrajectoryReader::readFrame(const std::size_t frameID, TrajectoryFrame* const o_frame)
+{
+    if (frameID >= m_offsets.size())
+    {
+        throw std::out_of_range("Trajectory frame is out of range.");
+    }
+
+    // continue from the last decoded frame if we can, otherwise from the nearest keyframe:
+    std::size_t start = frameID - (frameID % m_keyframeInterval);
+    if (m_decodedFrame != std::numeric_limits<std::size_t>::max() && m_decodedFrame >= start && m_decodedFrame <= frameID)
+    {
+        start = m_decodedFrame + 1;
+    }
+
+    for (std::size_t i = start; i <= frameID; i++)
+    {
+        decodeFrame(i);
+    }
+
+    o_frame->m_time = m_decodedHeader.m_time;
+    o_frame->m_volume = m_decodedHeader.m_volume;
+    o_frame->m_pressure = m_decodedHeader.m_pressure;
+
+    o_frame->m_positions.resize(m_numVertices);
+    for (std::size_t i = 0; i < m_numVertices; i++)
+    {
+        o_frame->m_positions[i] = Vec3(m_positions[3 * i], m_positions[3 * i + 1], m_positions[3 * i + 2]) * m_quantStep;
+    }
+
+    o_frame->m_targets.resize(m_numTargets);
+    for (std::size_t i = 0; i < m_numTargets; i++)
+    {
+        o_frame->m_targets[i] = Vec3(m_targets[3 * i], m_targets[3 * i + 1], m_targets[3 * i + 2]) * m_quantStep;
+    }
+}
+
+bool ee::TrajectoryReader::readFrameHeader(const uint64_t offset, FrameHeader* const o_header)
+{
+    m_file.seekg(offset);
+    return readRaw(m_file, &o_header->m_flags) && readRaw(m_file, &o_header->m_time) && readRaw(m_file, &o_header->m_volume) &&
+        readRaw(m_file, &o_header->m_pressure) && readRaw(m_file, &o_header->m_payloadSize);
+}
+
+void ee::TrajectoryReader::rebuildIndex(const uint64_t framesEnd)
+{
+    m_offsets.clear();
+    m_times.clear();
+
+    uint64_t offset = HEADER_SIZE;
+    FrameHeader header;
+    while (offset + FRAME_HEADER_SIZE <= framesEnd && readFrameHeader(offset, &header))
+    {
+        const uint64_t next = offset + FRAME_HEADER_SIZE + header.m_payloadSize;
+        if (next > framesEnd)
+        {
+            break; // the last frame was cut off
+        }
+
+        m_offsets.push_back(offset);
+        m_times.push_back(header.m_time);
+        offset = next;
+    }
+    m_file.clear();
+}
+
+void ee::TrajectoryReader::decodeFrame(const std::size_t frameID)
+{
+    FrameHeader header;
+    if (!readFrameHeader(m_offsets[frameID], &header))
+    {
+        throw std::runtime_error("Could not read the trajectory frame header.");
+    }
+
+    m_payload.resize(header.m_payloadSize);
+    m_file.read(reinterpret_cast<char*>(m_payload.data()), m_payload.size());
+    if (!m_file.good())
+    {
+        throw std::runtime_error("Could not read the trajectory frame data.");
+    }
+
+    const bool keyframe = (header.m_flags & TRAJ_FLAG_KEYFRAME) != 0;
+    if (!keyframe && m_decodedFrame + 1 != frameID)
+    {
+        throw std::logic_error("Trajectory delta frames have to be decoded in order.");
+    }
+
+    readEncoded(m_payload.data(), m_payload.data() + m_payload.size());
+    const uint64_t* encoded = m_encoded.data();
+    decodeValues(encoded, keyframe, &m_positions, &m_positionMotion);
+    decodeValues(encoded, keyframe, &m_targets, &m_targetMotion);
+
+    m_decodedFrame = frameID;
+    m_decodedHeader = header;
+}
+
+void ee::TrajectoryReader::readEncoded(const uint8_t* ptr, const uint8_t* const end)
+{
+    bool valid = true;
+    if (m_version == 1)
+    {
+        for (std::size_t i = 0; valid && i < m_encoded.size(); i++)
+        {
+            valid = traj::readVarint(ptr, end, &m_encoded[i]);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; valid && i < m_encoded.size(); i += TRAJ_BLOCK_SIZE)
+        {
+            valid = traj::readBlock(ptr, end, std::min<std::size_t>(TRAJ_BLOCK_SIZE, m_encoded.size() - i), &m_encoded[i]);
+        }
+    }
+
+    if (!valid)
+    {
+        throw std::runtime_error("Trajectory frame data is corrupted.");
+    }
+}
+
+void ee::TrajectoryReader::decodeValues(const uint64_t*& io_encoded, const bool keyframe, std::vector<int64_t>* const io_values,
+    std::vector<int64_t>* const io_motion)
+{
+    const bool predictMotion = m_version >= 2;
+    for (std::size_t i = 0; i < io_values->size(); i++)
+    {
+        int64_t& value = (*io_values)[i];
+        int64_t& motion = (*io_motion)[i];
+
+        const int64_t decoded = traj::zigZagDecode(*io_encoded++);
+        const int64_t next = keyframe ? decoded : value + (predictMotion ? motion : 0) + decoded;
+        motion = keyframe ? 0 : next - value;
+        value = next;
+    }
+}
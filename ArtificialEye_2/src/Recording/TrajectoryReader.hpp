@@ -0,0 +1,66 @@
+#pragma once
+
+#include "TrajectoryFormat.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ee
+{
+    // Reads trajectories written by the TrajectoryRecorder. Any frame can be read in any order,
+    // sequential reads continue from the last decoded frame instead of the previous keyframe.
+    class TrajectoryReader
+    {
+    public:
+        explicit TrajectoryReader(const std::string& file);
+
+        std::size_t getNumFrames() const;
+        std::size_t getNumVertices() const;
+        std::size_t getNumTargets() const;
+        Float       getQuantizationStep() const;
+        Float       getFrameTime(std::size_t frameID) const;
+
+        // returns the last frame with a time smaller or equal to the given time
+        std::size_t findFrame(Float time) const;
+
+        void readFrame(std::size_t frameID, TrajectoryFrame* o_frame);
+
+    private:
+        struct FrameHeader
+        {
+            uint8_t     m_flags;
+            double      m_time;
+            double      m_volume;
+            double      m_pressure;
+            uint32_t    m_payloadSize;
+        };
+
+        bool readFrameHeader(uint64_t offset, FrameHeader* o_header);
+        void rebuildIndex(uint64_t framesEnd);
+        void decodeFrame(std::size_t frameID);
+        void readEncoded(const uint8_t* ptr, const uint8_t* end);
+        void decodeValues(const uint64_t*& io_encoded, bool keyframe, std::vector<int64_t>* io_values, std::vector<int64_t>* io_motion);
+
+        std::ifstream           m_file;
+
+        std::size_t             m_numVertices;
+        std::size_t             m_numTargets;
+        unsigned                m_keyframeInterval;
+        Float                   m_quantStep;
+        uint32_t                m_version;
+
+        std::vector<uint64_t>   m_offsets;
+        std::vector<Float>      m_times;
+
+        // the state of the last decoded frame:
+        std::size_t             m_decodedFrame;
+        FrameHeader             m_decodedHeader;
+        std::vector<int64_t>    m_positions;
+        std::vector<int64_t>    m_targets;
+        std::vector<int64_t>    m_positionMotion;
+        std::vector<int64_t>    m_targetMotion;
+        std::vector<uint8_t>    m_payload;
+        std::vector<uint64_t>   m_encoded;
+    };
+}
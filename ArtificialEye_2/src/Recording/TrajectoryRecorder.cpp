@@ -0,0 +1,260 @@
+#include "TrajectoryRecorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <glm/glm.hpp>
+
+namespace
+{
+    // the simulation will wait on the writer if it gets this far behind
+    const std::size_t MAX_QUEUED_FRAMES = 1024;
+
+    template<typename T>
+    void writeRaw(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+ee::TrajectoryRecorder::TrajectoryRecorder(const std::string& file, const std::size_t numVertices, const std::vector<MeshFace>& faces,
+    const std::size_t numTargets, const Float quantStep, const unsigned keyframeInterval) :
+    m_numVertices(numVertices),
+    m_numTargets(numTargets),
+    m_quantStep(quantStep),
+    m_keyframeInterval(keyframeInterval == 0 ? 1 : keyframeInterval),
+    m_faces(faces),
+    m_fileName(file),
+    m_file(file, std::ios::binary | std::ios::trunc),
+    m_numFrames(0),
+    m_closing(false),
+    m_closed(false),
+    m_writeFailed(false),
+    m_prevPositions(3 * numVertices),
+    m_prevTargets(3 * numTargets),
+    m_positionMotion(3 * numVertices),
+    m_targetMotion(3 * numTargets)
+{
+    if (!m_file.is_open())
+    {
+        throw std::runtime_error("Could not open trajectory file " + file + " for writing.");
+    }
+
+    if (m_quantStep <= 0.0)
+    {
+        throw std::logic_error("The trajectory quantization step has to be greater than 0.");
+    }
+
+    m_file.write(TRAJ_FILE_MAGIC, sizeof(TRAJ_FILE_MAGIC));
+    writeRaw(m_file, TRAJ_VERSION);
+    writeRaw(m_file, static_cast<uint32_t>(m_numVertices));
+    writeRaw(m_file, static_cast<uint32_t>(m_numTargets));
+    writeRaw(m_file, static_cast<uint32_t>(m_keyframeInterval));
+    writeRaw(m_file, static_cast<double>(m_quantStep));
+
+    m_writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+}
+
+ee::TrajectoryRecorder::~TrajectoryRecorder()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "[EXCEP THROWN]: " << std::endl;
+        std::cout << e.what() << std::endl;
+    }
+}
+
+void ee::TrajectoryRecorder::record(const Float time, const Mesh& mesh, const std::vector<SBPointConstraint*>& targets,
+    const Float pressure)
+{
+    if (mesh.getNumVertices() != m_numVertices || targets.size() != m_numTargets)
+    {
+        throw std::logic_error("The recorded frame doesn't match the layout of the trajectory file.");
+    }
+
+    std::unique_ptr<TrajectoryFrame> frame;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_closing)
+        {
+            throw std::logic_error("Can't record to a trajectory that was closed.");
+        }
+
+        m_queueCond.wait(lock, [this]() { return m_queue.size() < MAX_QUEUED_FRAMES; });
+        if (!m_freeFrames.empty())
+        {
+            frame = std::move(m_freeFrames.back());
+            m_freeFrames.pop_back();
+        }
+    }
+
+    if (!frame)
+    {
+        frame.reset(new TrajectoryFrame());
+    }
+
+    // copy the frame, this is all the work the simulation thread does:
+    frame->m_time = time;
+    frame->m_pressure = pressure;
+
+    const std::vector<Vertex>& vertices = mesh.getVerticesData();
+    frame->m_positions.resize(m_numVertices);
+    for (std::size_t i = 0; i < m_numVertices; i++)
+    {
+        frame->m_positions[i] = vertices[i].m_position;
+    }
+
+    frame->m_targets.resize(m_numTargets);
+    for (std::size_t i = 0; i < m_numTargets; i++)
+    {
+        frame->m_targets[i] = targets[i]->m_point;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+        m_numFrames++;
+    }
+    m_queueCond.notify_all();
+}
+
+void ee::TrajectoryRecorder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed)
+        {
+            return;
+        }
+        m_closing = true;
+    }
+    m_queueCond.notify_all();
+
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+
+    // write the index and the trailer (a file without them can still be read, just slower):
+    if (!m_writeFailed)
+    {
+        const uint64_t indexOffset = static_cast<uint64_t>(m_file.tellp());
+        writeRaw(m_file, static_cast<uint64_t>(m_index.size()));
+        for (const auto& entry : m_index)
+        {
+            writeRaw(m_file, entry.first);
+            writeRaw(m_file, static_cast<double>(entry.second));
+        }
+        writeRaw(m_file, indexOffset);
+        m_file.write(TRAJ_INDEX_MAGIC, sizeof(TRAJ_INDEX_MAGIC));
+    }
+    m_file.close();
+    const bool failed = m_writeFailed || m_file.fail();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+
+    if (failed)
+    {
+        std::ostringstream str;
+        str << "Could not write the trajectory file " << m_fileName << ", the frames after " << m_index.size() << " may be missing.";
+        throw std::runtime_error(str.str());
+    }
+}
+
+std::size_t ee::TrajectoryRecorder::getNumFramesRecorded() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numFrames;
+}
+
+void ee::TrajectoryRecorder::writerLoop()
+{
+    while (true)
+    {
+        std::unique_ptr<TrajectoryFrame> frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueCond.wait(lock, [this]() { return !m_queue.empty() || m_closing; });
+            if (m_queue.empty())
+            {
+                return; // closing and everything was written
+            }
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_queueCond.notify_all(); // there is room in the queue again
+
+        // after a failed write the remaining frames are dropped, close() reports it:
+        if (!m_writeFailed)
+        {
+            writeFrame(*frame);
+            if (!m_file)
+            {
+                m_index.pop_back();
+                m_writeFailed = true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeFrames.push_back(std::move(frame));
+    }
+}
+
+void ee::TrajectoryRecorder::writeFrame(const TrajectoryFrame& frame)
+{
+    const bool keyframe = (m_index.size() % m_keyframeInterval) == 0;
+
+    // the volume is only needed here, so the simulation thread doesn't compute it:
+    Float volume = 0.0;
+    for (const MeshFace& face : m_faces)
+    {
+        volume += glm::dot(frame.m_positions[face(0)], glm::cross(frame.m_positions[face(1)], frame.m_positions[face(2)]));
+    }
+    volume = std::abs(volume) / 6.0;
+
+    m_encoded.clear();
+    encodeValues(frame.m_positions, keyframe, &m_prevPositions, &m_positionMotion);
+    encodeValues(frame.m_targets, keyframe, &m_prevTargets, &m_targetMotion);
+    m_payload.clear();
+    for (std::size_t i = 0; i < m_encoded.size(); i += TRAJ_BLOCK_SIZE)
+    {
+        traj::writeBlock(&m_encoded[i], std::min<std::size_t>(TRAJ_BLOCK_SIZE, m_encoded.size() - i), &m_payload);
+    }
+
+    m_index.push_back(std::make_pair(static_cast<uint64_t>(m_file.tellp()), frame.m_time));
+
+    writeRaw(m_file, keyframe ? TRAJ_FLAG_KEYFRAME : static_cast<uint8_t>(0));
+    writeRaw(m_file, static_cast<double>(frame.m_time));
+    writeRaw(m_file, static_cast<double>(volume));
+    writeRaw(m_file, static_cast<double>(frame.m_pressure));
+    writeRaw(m_file, static_cast<uint32_t>(m_payload.size()));
+    m_file.write(reinterpret_cast<const char*>(m_payload.data()), m_payload.size());
+}
+
+void ee::TrajectoryRecorder::encodeValues(const std::vector<Vec3>& values, const bool keyframe, std::vector<int64_t>* const io_prev,
+    std::vector<int64_t>* const io_motion)
+{
+    const Float invStep = 1.0 / m_quantStep;
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            const int64_t quantized = static_cast<int64_t>(std::floor(values[i][c] * invStep + 0.5));
+            int64_t& prev = (*io_prev)[3 * i + c];
+            int64_t& motion = (*io_motion)[3 * i + c];
+            m_encoded.push_back(traj::zigZagEncode(keyframe ? quantized : quantized - (prev + motion)));
+            motion = keyframe ? 0 : quantized - prev;
+            prev = quantized;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "TrajectoryFormat.hpp"
+#include "../Rendering/Modeling/Mesh.hpp"
+#include "../SoftBody/Constraints/SBPointConstraint.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ee
+{
+    // Streams lens trajectories (vertex positions, constraint targets, volume and pressure) to disk.
+    // The simulation thread only copies the frame into a pooled buffer, the volume, the quantization,
+    // the delta encoding and the writing itself happen on a background I/O thread.
+    class TrajectoryRecorder
+    {
+    public:
+        // faces are the (fixed) faces of the recorded mesh, for the volume
+        TrajectoryRecorder(const std::string& file, std::size_t numVertices, const std::vector<MeshFace>& faces,
+            std::size_t numTargets, Float quantStep = 1.0e-5, unsigned keyframeInterval = 256);
+        ~TrajectoryRecorder();
+
+        void record(Float time, const Mesh& mesh, const std::vector<SBPointConstraint*>& targets, Float pressure);
+
+        // Flushes all of the queued frames and writes the frame index, no frames can be recorded after this.
+        // Throws if any of the file could not be written (the frames after a failed write are dropped).
+        void close();
+
+        std::size_t getNumFramesRecorded() const;
+
+    private:
+        TrajectoryRecorder(const TrajectoryRecorder&);
+        TrajectoryRecorder& operator=(const TrajectoryRecorder&);
+
+        void writerLoop();
+        void writeFrame(const TrajectoryFrame& frame);
+        void encodeValues(const std::vector<Vec3>& values, bool keyframe, std::vector<int64_t>* io_prev, std::vector<int64_t>* io_motion);
+
+        const std::size_t   m_numVertices;
+        const std::size_t   m_numTargets;
+        const Float         m_quantStep;
+        const unsigned      m_keyframeInterval;
+        const std::vector<MeshFace> m_faces;
+        const std::string   m_fileName;
+
+        std::ofstream       m_file;
+
+        // shared between the simulation and the writer thread:
+        mutable std::mutex                              m_mutex;
+        std::condition_variable                         m_queueCond;
+        std::deque<std::unique_ptr<TrajectoryFrame>>    m_queue;
+        std::vector<std::unique_ptr<TrajectoryFrame>>   m_freeFrames;
+        std::size_t                                     m_numFrames;
+        bool                                            m_closing;
+        bool                                            m_closed;
+        bool                                            m_writeFailed;
+
+        // only touched by the writer thread:
+        std::vector<int64_t>                            m_prevPositions;
+        std::vector<int64_t>                            m_prevTargets;
+        std::vector<int64_t>                            m_positionMotion;
+        std::vector<int64_t>                            m_targetMotion;
+        std::vector<uint64_t>                           m_encoded;
+        std::vector<uint8_t>                            m_payload;
+        std::vector<std::pair<uint64_t, Float>>         m_index;
+
+        std::thread                                     m_writer;
+    };
+}
@@ -0,0 +1,317 @@
+#include "AdaptiveSubdivision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const char FACE_KEEP    = 0;
+    const char FACE_RED     = 1;
+    const char FACE_GREEN   = 2;
+
+    ee::Vec3 faceNormal(const std::vector<ee::Vertex>& vertices, const ee::MeshFace& face)
+    {
+        const ee::Vec3 n = glm::cross(vertices[face(1)].m_position - vertices[face(0)].m_position,
+            vertices[face(2)].m_position - vertices[face(0)].m_position);
+        const ee::Float length = glm::length(n);
+        return length > 0.0 ? n / length : ee::Vec3();
+    }
+
+    bool sameFaces(const std::vector<ee::MeshFace>& a, const std::vector<ee::MeshFace>& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](const ee::MeshFace& x, const ee::MeshFace& y) { return x(0) == y(0) && x(1) == y(1) && x(2) == y(2); });
+    }
+
+    using AdaptiveLevel = ee::AdaptiveSubdivWorkspace::Level;
+
+    void refineLevel(ee::AdaptiveSubdivWorkspace* const workspace, const AdaptiveLevel& src, AdaptiveLevel* const o_dst)
+    {
+        ee::SubdivisionTopology* const topology = &workspace->m_topology;
+        const std::vector<ee::MeshFace>& faces = src.m_faces;
+        topology->build(src.m_vertices.size(), faces);
+
+        // red faces split all of their edges, the closure repeats until every face is split on at most one
+        // edge, and green faces aren't split at all:
+        std::vector<char>& type = workspace->m_faceTypes;
+        std::vector<char>& split = workspace->m_splitEdges;
+        type.assign(faces.size(), FACE_KEEP);
+        split.assign(topology->getNumEdges(), 0);
+        auto makeRed = [&](const std::size_t f)
+        {
+            type[f] = FACE_RED;
+            for (int k = 0; k < 3; k++)
+            {
+                split[topology->getFaceEdge(f, k)] = 1;
+            }
+        };
+
+        for (std::size_t f = 0; f < faces.size(); f++)
+        {
+            if (src.m_marked[f])
+            {
+                makeRed(f);
+            }
+        }
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (std::size_t f = 0; f < faces.size(); f++)
+            {
+                if (type[f] == FACE_RED)
+                {
+                    continue;
+                }
+
+                int numSplit = 0;
+                for (int k = 0; k < 3; k++)
+                {
+                    numSplit += split[topology->getFaceEdge(f, k)];
+                }
+
+                if (numSplit >= 2 || (numSplit == 1 && src.m_green[f]))
+                {
+                    makeRed(f);
+                    changed = true;
+                }
+                else
+                {
+                    type[f] = numSplit == 1 ? FACE_GREEN : FACE_KEEP;
+                }
+            }
+        }
+
+        // the new vertices follow the old ones in edge order:
+        std::vector<int>& edgePoints = workspace->m_edgePoints;
+        edgePoints.assign(topology->getNumEdges(), -1);
+        int nextPoint = static_cast<int>(src.m_vertices.size());
+        for (std::size_t e = 0; e < topology->getNumEdges(); e++)
+        {
+            if (split[e])
+            {
+                edgePoints[e] = nextPoint++;
+            }
+        }
+
+        // loop rules, only the vertices of red faces move:
+        std::vector<char>& moved = workspace->m_moved;
+        moved.assign(src.m_vertices.size(), 0);
+        for (std::size_t f = 0; f < faces.size(); f++)
+        {
+            if (type[f] == FACE_RED)
+            {
+                moved[faces[f](0)] = moved[faces[f](1)] = moved[faces[f](2)] = 1;
+            }
+        }
+
+        o_dst->m_vertices.resize(nextPoint);
+        for (std::size_t v = 0; v < src.m_vertices.size(); v++)
+        {
+            ee::Vertex result = src.m_vertices[v];
+            const std::size_t n = topology->getValence(v);
+            if (moved[v] && n > 0)
+            {
+                ee::Vec3 sumPoint;
+                for (const int* it = topology->getRingBegin(v); it != topology->getRingEnd(v); ++it)
+                {
+                    sumPoint += src.m_vertices[*it].m_position;
+                }
+
+                const ee::Float beta = ee::SubdivisionTopology::betaConst(n);
+                result.m_position = (1.0 - beta * n) * src.m_vertices[v].m_position + beta * sumPoint;
+            }
+            o_dst->m_vertices[v] = result;
+        }
+
+        for (std::size_t e = 0; e < topology->getNumEdges(); e++)
+        {
+            if (!split[e])
+            {
+                continue;
+            }
+
+            const ee::Vertex& v0 = src.m_vertices[topology->getEdgeVertex(e, 0)];
+            const ee::Vertex& v1 = src.m_vertices[topology->getEdgeVertex(e, 1)];
+
+            ee::Vertex result;
+            result.m_textCoord = 0.5 * (v0.m_textCoord + v1.m_textCoord);
+            if (topology->isInteriorEdge(e))
+            {
+                result.m_position = 3.0 / 8.0 * (v0.m_position + v1.m_position) +
+                    1.0 / 8.0 * (src.m_vertices[topology->getOppositeVertex(faces, e, 0)].m_position +
+                        src.m_vertices[topology->getOppositeVertex(faces, e, 1)].m_position);
+            }
+            else
+            {
+                result.m_position = 0.5 * (v0.m_position + v1.m_position);
+            }
+            o_dst->m_vertices[edgePoints[e]] = result;
+        }
+
+        // faces, red children stay marked if their parent was marked (not just made red by the closure):
+        o_dst->m_faces.clear();
+        o_dst->m_parents.clear();
+        o_dst->m_marked.clear();
+        o_dst->m_green.clear();
+        auto addFace = [o_dst](const ee::MeshFace& face, const int parent, const char marked, const char green)
+        {
+            o_dst->m_faces.push_back(face);
+            o_dst->m_parents.push_back(parent);
+            o_dst->m_marked.push_back(marked);
+            o_dst->m_green.push_back(green);
+        };
+
+        for (std::size_t f = 0; f < faces.size(); f++)
+        {
+            const ee::MeshFace& face = faces[f];
+            const int parent = src.m_parents[f];
+            if (type[f] == FACE_RED)
+            {
+                const int e0 = edgePoints[topology->getFaceEdge(f, 0)];
+                const int e1 = edgePoints[topology->getFaceEdge(f, 1)];
+                const int e2 = edgePoints[topology->getFaceEdge(f, 2)];
+                const char marked = src.m_marked[f];
+                addFace(ee::MeshFace(e0, e1, e2), parent, marked, 0);
+                addFace(ee::MeshFace(e0, e2, face(0)), parent, marked, 0);
+                addFace(ee::MeshFace(e0, e1, face(1)), parent, marked, 0);
+                addFace(ee::MeshFace(e1, e2, face(2)), parent, marked, 0);
+            }
+            else if (type[f] == FACE_GREEN)
+            {
+                // bisect from the split edge k to the opposite vertex, keeping the winding:
+                int k = 0;
+                while (!split[topology->getFaceEdge(f, k)])
+                {
+                    k++;
+                }
+
+                const int mid = edgePoints[topology->getFaceEdge(f, k)];
+                const int a = face(k);
+                const int b = face((k + 1) % 3);
+                const int opposite = face((k + 2) % 3);
+                addFace(ee::MeshFace(a, mid, opposite), parent, 0, 1);
+                addFace(ee::MeshFace(mid, b, opposite), parent, 0, 1);
+            }
+            else
+            {
+                addFace(face, parent, 0, src.m_green[f]);
+            }
+        }
+    }
+}
+
+void ee::markFacesNearAxis(const Mesh& mesh, const Ray axis, const Float radius, FaceMarks* const io_marks)
+{
+    io_marks->resize(std::max(io_marks->size(), mesh.getNumMeshFaces()), false);
+
+    const Vec3 dir = glm::normalize(axis.m_dir);
+    for (std::size_t f = 0; f < mesh.getNumMeshFaces(); f++)
+    {
+        const MeshFace& face = mesh.getMeshFace(f);
+        const Vec3 center = (mesh.getTransformedVertex(face(0)).m_position + mesh.getTransformedVertex(face(1)).m_position +
+            mesh.getTransformedVertex(face(2)).m_position) / 3.0;
+
+        const Vec3 offset = center - axis.m_origin;
+        if (glm::length(offset - glm::dot(offset, dir) * dir) <= radius)
+        {
+            (*io_marks)[f] = true;
+        }
+    }
+}
+
+void ee::markCurvedFaces(const Mesh& mesh, const Float maxAngle, FaceMarks* const io_marks)
+{
+    io_marks->resize(std::max(io_marks->size(), mesh.getNumMeshFaces()), false);
+
+    const std::vector<Vertex>& vertices = mesh.getVerticesData();
+    const std::vector<MeshFace>& faces = mesh.getMeshFaceData();
+
+    SubdivisionTopology topology;
+    topology.build(vertices.size(), faces);
+
+    const Float minCos = std::cos(maxAngle);
+    for (std::size_t e = 0; e < topology.getNumEdges(); e++)
+    {
+        if (topology.getNumEdgeFaces(e) != 2)
+        {
+            continue;
+        }
+
+        // the winding isn't consistent on every mesh, so the sign of the normals is ignored:
+        const std::size_t f0 = topology.getEdgeFace(e, 0);
+        const std::size_t f1 = topology.getEdgeFace(e, 1);
+        if (std::abs(glm::dot(faceNormal(vertices, faces[f0]), faceNormal(vertices, faces[f1]))) < minCos)
+        {
+            (*io_marks)[f0] = true;
+            (*io_marks)[f1] = true;
+        }
+    }
+}
+
+void ee::markParentFaces(const std::vector<std::size_t>& refinedFaces, const std::vector<int>& parentFaces, FaceMarks* const io_marks)
+{
+    for (std::size_t face : refinedFaces)
+    {
+        if (face < parentFaces.size() && parentFaces[face] >= 0)
+        {
+            const std::size_t parent = static_cast<std::size_t>(parentFaces[face]);
+            if (parent >= io_marks->size())
+            {
+                io_marks->resize(parent + 1, false);
+            }
+            (*io_marks)[parent] = true;
+        }
+    }
+}
+
+ee::Mesh ee::adaptiveLoopSubdiv(const Mesh& mesh, const FaceMarks& marks, const int recursion, std::vector<int>* const o_parentFaces)
+{
+    AdaptiveSubdivWorkspace workspace;
+    Mesh result;
+    adaptiveLoopSubdiv(mesh, marks, recursion, &result, o_parentFaces, &workspace);
+    return result;
+}
+
+void ee::adaptiveLoopSubdiv(const Mesh& mesh, const FaceMarks& marks, const int recursion, Mesh* const o_mesh,
+    std::vector<int>* const o_parentFaces, AdaptiveSubdivWorkspace* const workspace)
+{
+    AdaptiveLevel* src = &workspace->m_levels[0];
+    AdaptiveLevel* dst = &workspace->m_levels[1];
+
+    src->m_vertices = mesh.getVerticesData();
+    src->m_faces = mesh.getMeshFaceData();
+    src->m_parents.resize(src->m_faces.size());
+    src->m_marked.resize(src->m_faces.size());
+    src->m_green.assign(src->m_faces.size(), 0);
+    for (std::size_t f = 0; f < src->m_faces.size(); f++)
+    {
+        src->m_parents[f] = static_cast<int>(f);
+        src->m_marked[f] = f < marks.size() && marks[f];
+    }
+
+    for (int level = 0; level < recursion; level++)
+    {
+        if (std::find(src->m_marked.begin(), src->m_marked.end(), 1) == src->m_marked.end())
+        {
+            break; // nothing left to refine
+        }
+
+        refineLevel(workspace, *src, dst);
+        std::swap(src, dst);
+    }
+
+    // The result trades places with the buffers of the mesh, so the workspace keeps them for the next call.
+    // The refinement mostly ends up with the same faces as last time, then the faces of the mesh stay.
+    if (o_parentFaces)
+    {
+        o_parentFaces->swap(src->m_parents);
+    }
+    const Mesh& prevMesh = *o_mesh;
+    if (!sameFaces(prevMesh.getMeshFaceData(), src->m_faces))
+    {
+        o_mesh->editMeshFaces().swap(src->m_faces);
+    }
+    o_mesh->editVertices().swap(src->m_vertices);
+}
\ No newline at end of file
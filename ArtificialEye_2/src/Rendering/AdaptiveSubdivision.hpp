@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Modeling/Mesh.hpp"
+#include "SubdivisionTopology.hpp"
+
+#include <vector>
+
+namespace ee
+{
+    // Faces of the control mesh that should be refined. The marking helpers only add marks, so several
+    // criteria can be combined, the vector is resized to the number of faces if needed.
+    using FaceMarks = std::vector<bool>;
+
+    // Faces whose center (in world space, with the model transform of the mesh) is within radius of the axis.
+    void markFacesNearAxis(const Mesh& mesh, Ray axis, Float radius, FaceMarks* io_marks);
+
+    // Faces that have an edge with a dihedral angle (between the face normals) above maxAngle, in radians.
+    void markCurvedFaces(const Mesh& mesh, Float maxAngle, FaceMarks* io_marks);
+
+    // Marks the control mesh faces of faces of a refined mesh (for example the faces hit by the RayTracer).
+    void markParentFaces(const std::vector<std::size_t>& refinedFaces, const std::vector<int>& parentFaces, FaceMarks* io_marks);
+
+    // Scratch storage of adaptiveLoopSubdiv, reusing it between calls avoids the allocations once it has grown.
+    struct AdaptiveSubdivWorkspace
+    {
+        // state of one level of the refinement:
+        struct Level
+        {
+            std::vector<Vertex>     m_vertices;
+            std::vector<MeshFace>   m_faces;
+            std::vector<int>        m_parents;
+            std::vector<char>       m_marked;
+            std::vector<char>       m_green;    // made by a green split, never split green again
+        };
+
+        SubdivisionTopology     m_topology;
+        Level                   m_levels[2];
+        std::vector<char>       m_faceTypes;
+        std::vector<char>       m_splitEdges;
+        std::vector<int>        m_edgePoints;
+        std::vector<char>       m_moved;
+    };
+
+    // Loop subdivision of the marked faces only, recursion times. Marked faces are split in four (red), the
+    // faces next to them are bisected (green) so there are no T-junctions and the surface doesn't crack.
+    // Faces that would be split on more than one edge, or green faces that would be split again, are made
+    // red instead, so the triangles don't degenerate. Old vertices keep their IDs (like loopSubdiv) and
+    // o_parentFaces (if given) holds the control mesh face of every refined face.
+    Mesh adaptiveLoopSubdiv(const Mesh& mesh, const FaceMarks& marks, int recursion, std::vector<int>* o_parentFaces = nullptr);
+
+    // Same, but refines into o_mesh (which must not be mesh) as one update of its vertices, and of its faces
+    // if they changed. Written in place unless the buffers of o_mesh are shared (see Mesh).
+    void adaptiveLoopSubdiv(const Mesh& mesh, const FaceMarks& marks, int recursion, Mesh* o_mesh,
+        std::vector<int>* o_parentFaces, AdaptiveSubdivWorkspace* workspace);
+}
\ No newline at end of file
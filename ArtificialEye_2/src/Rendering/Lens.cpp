@@ -1,5 +1,8 @@
 #include "Lens.hpp"
 
+#include <cmath>
+#include <stdexcept>
+
 ee::Lens::Lens(Mesh* mesh, int nLat, int nLon) :
     m_mesh(mesh),
     m_nLatitudes(nLat),
@@ -7,10 +10,11 @@ ee::Lens::Lens(Mesh* mesh, int nLat, int nLon) :
     m_constraintStart(-1),
     m_constraintEnd(-1)
 {
-    //if (m_mesh->getMeshType() != MeshType::UVSPHERE)
-    //{
-    //    throw std::logic_error("Lens can only take UVSphere meshes.");
-    //}
+    if (m_mesh->getMeshType() != MeshType::UVSPHERE)
+    {
+        binRings();
+        return;
+    }
 
     m_latitudes.reserve(nLat);
     for (int i = 0; i < nLat; i++)
@@ -34,29 +38,65 @@ ee::Lens::Lens(Mesh* mesh, int nLat, int nLon) :
         }
         m_longitudes.push_back(temp);
     }
+
+    m_vertexLatitudes.assign(m_mesh->getNumVertices(), -1);
+    m_vertexLongitudes.assign(m_mesh->getNumVertices(), -1);
+    for (int i = 1; i < nLat * nLon + 1; i++)
+    {
+        m_vertexLatitudes[i] = (i - 1) / m_nLongitudes;
+        m_vertexLongitudes[i] = (i - 1) % m_nLongitudes;
+    }
+}
+
+void ee::Lens::binRings()
+{
+    m_latitudes.resize(m_nLatitudes);
+    m_longitudes.resize(m_nLongitudes);
+    m_vertexLatitudes.resize(m_mesh->getNumVertices());
+    m_vertexLongitudes.resize(m_mesh->getNumVertices());
+
+    for (int i = 0; i < static_cast<int>(m_mesh->getNumVertices()); i++)
+    {
+        const Vec3 position = glm::normalize(m_mesh->getVertex(i).m_position);
+        const Float polar = std::acos(glm::clamp(position.y, -1.0, 1.0));
+        Float azimuth = std::atan2(position.z, position.x);
+        if (azimuth < 0.0)
+        {
+            azimuth += 2.0 * glm::pi<Float>();
+        }
+
+        const int lat = glm::min(static_cast<int>(polar / glm::pi<Float>() * m_nLatitudes), m_nLatitudes - 1);
+        const int lon = static_cast<int>(azimuth / (2.0 * glm::pi<Float>()) * m_nLongitudes) % m_nLongitudes;
+
+        m_latitudes[lat].push_back(i);
+        m_longitudes[lon].push_back(i);
+        m_vertexLatitudes[i] = lat;
+        m_vertexLongitudes[i] = lon;
+    }
 }
 
 std::vector<ee::SBPointConstraint*> ee::Lens::addConstraints(int thickness, ee::SBSimulation* sim)
 {
     std::vector<ee::SBPointConstraint*> constraints;
 
-    int beginIndex = (m_nLatitudes / 2 - (thickness / 2 + 1)) * (m_nLongitudes) + 1;
-    int endIndex;
-    for (int i = 0, sub = (thickness / 2 + 1); i < thickness; i++, sub--)
+    // the band of rings around the equator:
+    const int begin = m_nLatitudes / 2 - (thickness / 2 + 1);
+    if (begin < 0 || begin + thickness > m_nLatitudes)
     {
-        const int index = (m_nLatitudes / 2 - sub) * (m_nLongitudes) + 1;
-        endIndex = index;
-        const int end = index + m_nLongitudes;
+        throw std::logic_error("The constraint band is thicker than the lens has rings.");
+    }
 
-        for (int j = index; j < end; j++)
+    for (int ring = begin; ring < begin + thickness; ring++)
+    {
+        for (const int j : m_latitudes[ring])
         {
             auto ptr = sim->addConstraint(&ee::SBPointConstraint(m_mesh->getVertex(j).m_position, sim->getVertexObject(j)));
             constraints.push_back(ptr);
         }
     }
 
-    m_constraintStart = getLatitudeIndex(beginIndex);
-    m_constraintEnd   = getLatitudeIndex(endIndex);
+    m_constraintStart = begin;
+    m_constraintEnd   = begin + thickness - 1;
 
     return std::move(constraints);
 }
@@ -83,12 +123,12 @@ int ee::Lens::getNumLongitudes() const
 
 int ee::Lens::getLatitudeIndex(int index) const
 {
-    return (index - 1) / m_nLongitudes;
+    return m_vertexLatitudes[index];
 }
 
 int ee::Lens::getLongitudeIndex(int index) const
 {
-    return (index - 1) % m_nLongitudes;
+    return m_vertexLongitudes[index];
 }
 
 glm::vec3 ee::Lens::getNormal(int faceID) const
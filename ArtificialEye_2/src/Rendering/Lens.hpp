@@ -6,6 +6,9 @@
 
 namespace ee
 {
+    // The rings of a UV sphere are its latitudes and longitudes. Any other sphere (an icosphere) is split into
+    // nLat bands of equal polar angle around its y axis and nLon sectors of equal azimuth, which take the
+    // place of the rings.
     class Lens
     {
     public:
@@ -19,6 +22,7 @@ namespace ee
         int getNumLatitudes() const;
         int getNumLongitudes() const;
 
+        // ring of a vertex, -1 for the poles of a UV sphere
         int getLatitudeIndex(int index) const;
         int getLongitudeIndex(int index) const;
 
@@ -32,8 +36,12 @@ namespace ee
         int getConstraintEnd() const;
 
     private:
+        void binRings();
+
         std::vector<std::vector<int>> m_latitudes;
         std::vector<std::vector<int>> m_longitudes;
+        std::vector<int> m_vertexLatitudes;
+        std::vector<int> m_vertexLongitudes;
 
         Mesh* const m_mesh;
         const int   m_nLatitudes;
@@ -0,0 +1,670 @@
+#include "LimitSurface.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <glm/gtx/norm.hpp>
+
+namespace
+{
+    const int       NUM_MONOMIALS           = 15;   // quartic in two variables
+    const int       MAX_PATCH_DEPTH         = 10;
+    const int       MAX_NEWTON_ITERATIONS   = 16;
+    const int       MAX_FACE_CHANGES        = 8;
+    const ee::Float NEWTON_TOLERANCE        = 1.0e-10;
+    const ee::Float PARAM_EPS               = 1.0e-9;
+    const ee::Float INVALID_PARAM           = -1.0e6;   // vertices outside of the root face
+
+    // exponents of the monomials s^p * t^q, the samples are at (p / 4, q / 4) in the same order
+    void monomialExponents(int* o_p, int* o_q)
+    {
+        int m = 0;
+        for (int p = 0; p <= 4; p++)
+        {
+            for (int q = 0; q <= 4 - p; q++, m++)
+            {
+                o_p[m] = p;
+                o_q[m] = q;
+            }
+        }
+    }
+
+    bool isValidParam(const ee::Vec2& param)
+    {
+        return param.x > INVALID_PARAM * 0.5;
+    }
+
+    // local (s, t) of param in the triangle with the given corner params
+    ee::Vec2 toLocal(const ee::Vec2 corners[3], const ee::Vec2& param, ee::Float o_inv[4])
+    {
+        const ee::Vec2 e0 = corners[1] - corners[0];
+        const ee::Vec2 e1 = corners[2] - corners[0];
+        const ee::Float det = e0.x * e1.y - e1.x * e0.y;
+        o_inv[0] = e1.y / det;
+        o_inv[1] = -e1.x / det;
+        o_inv[2] = -e0.y / det;
+        o_inv[3] = e0.x / det;
+
+        const ee::Vec2 d = param - corners[0];
+        return ee::Vec2(o_inv[0] * d.x + o_inv[1] * d.y, o_inv[2] * d.x + o_inv[3] * d.y);
+    }
+
+    void controlBaryCentric(const ee::Vec3& p, const ee::Vec3& a, const ee::Vec3& b, const ee::Vec3& c, ee::Float* o_u, ee::Float* o_v)
+    {
+        const ee::Vec3 v0 = b - a, v1 = c - a, v2 = p - a;
+        const ee::Float d00 = glm::dot(v0, v0);
+        const ee::Float d01 = glm::dot(v0, v1);
+        const ee::Float d11 = glm::dot(v1, v1);
+        const ee::Float d20 = glm::dot(v2, v0);
+        const ee::Float d21 = glm::dot(v2, v1);
+        const ee::Float denom = d00 * d11 - d01 * d01;
+        *o_u = (d11 * d20 - d01 * d21) / denom;
+        *o_v = (d00 * d21 - d01 * d20) / denom;
+    }
+}
+
+ee::LimitSurface::LimitSurface(const Mesh* const mesh) :
+    m_mesh(mesh)
+{
+    // inverse of the matrix that samples the monomials at the dyadic points (Gauss-Jordan):
+    int p[NUM_MONOMIALS], q[NUM_MONOMIALS];
+    monomialExponents(p, q);
+
+    Float a[NUM_MONOMIALS][2 * NUM_MONOMIALS];
+    for (int k = 0; k < NUM_MONOMIALS; k++)
+    {
+        for (int m = 0; m < NUM_MONOMIALS; m++)
+        {
+            a[k][m] = std::pow(p[k] / 4.0, p[m]) * std::pow(q[k] / 4.0, q[m]);
+            a[k][NUM_MONOMIALS + m] = k == m ? 1.0 : 0.0;
+        }
+    }
+
+    for (int col = 0; col < NUM_MONOMIALS; col++)
+    {
+        int pivot = col;
+        for (int row = col + 1; row < NUM_MONOMIALS; row++)
+        {
+            if (std::abs(a[row][col]) > std::abs(a[pivot][col]))
+            {
+                pivot = row;
+            }
+        }
+        std::swap_ranges(a[col], a[col] + 2 * NUM_MONOMIALS, a[pivot]);
+
+        const Float inv = 1.0 / a[col][col];
+        for (int j = 0; j < 2 * NUM_MONOMIALS; j++)
+        {
+            a[col][j] *= inv;
+        }
+
+        for (int row = 0; row < NUM_MONOMIALS; row++)
+        {
+            if (row != col && a[row][col] != 0.0)
+            {
+                const Float factor = a[row][col];
+                for (int j = 0; j < 2 * NUM_MONOMIALS; j++)
+                {
+                    a[row][j] -= factor * a[col][j];
+                }
+            }
+        }
+    }
+
+    for (int m = 0; m < NUM_MONOMIALS; m++)
+    {
+        for (int k = 0; k < NUM_MONOMIALS; k++)
+        {
+            m_vandermondeInv[m * NUM_MONOMIALS + k] = a[m][NUM_MONOMIALS + k];
+        }
+    }
+
+    rebuild();
+}
+
+void ee::LimitSurface::rebuild()
+{
+    const std::vector<MeshFace>& faces = m_mesh->getMeshFaceData();
+    m_topology.build(m_mesh->getNumVertices(), faces);
+    for (std::size_t e = 0; e < m_topology.getNumEdges(); e++)
+    {
+        if (!m_topology.isInteriorEdge(e))
+        {
+            throw std::runtime_error("The limit surface can only be evaluated on closed meshes.");
+        }
+    }
+
+    m_vertexFaceStart.assign(m_mesh->getNumVertices() + 1, 0);
+    for (const MeshFace& face : faces)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            m_vertexFaceStart[face(k) + 1]++;
+        }
+    }
+    for (std::size_t v = 0; v < m_mesh->getNumVertices(); v++)
+    {
+        m_vertexFaceStart[v + 1] += m_vertexFaceStart[v];
+    }
+
+    m_vertexFaces.resize(m_vertexFaceStart.back());
+    std::vector<std::size_t> fill(m_vertexFaceStart.begin(), m_vertexFaceStart.end() - 1);
+    for (std::size_t f = 0; f < faces.size(); f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            m_vertexFaces[fill[faces[f](k)]++] = static_cast<int>(f);
+        }
+    }
+
+    // every patch is built here, so evaluating only reads them (on any number of threads):
+    m_patches.clear();
+    m_patches.resize(faces.size());
+    parallelFor(0, faces.size(), [this](const std::size_t face)
+    {
+        m_patches[face].reset(new FacePatch());
+        buildFacePatch(face, m_patches[face].get());
+        buildChildren(m_patches[face]->m_root.get());
+    });
+}
+
+void ee::LimitSurface::evaluate(const MeshSnapshot& mesh, const std::size_t face, const Float u, const Float v, Vec3* const o_position, Vec3* const o_normal, Vec3* const o_du, Vec3* const o_dv) const
+{
+    const FacePatch* patch;
+    const PatchNode* const node = findNode(face, Vec2(u, v), &patch);
+
+    Float inv[4];
+    const Vec2 local = toLocal(node->m_corners, Vec2(u, v), inv);
+    const std::size_t numControls = patch->m_controls.size();
+
+    Vec3 position, ds, dt;
+    if (node->m_regular)
+    {
+        int p[NUM_MONOMIALS], q[NUM_MONOMIALS];
+        monomialExponents(p, q);
+
+        Float powS[5] = {1.0}, powT[5] = {1.0};
+        for (int i = 1; i <= 4; i++)
+        {
+            powS[i] = powS[i - 1] * local.x;
+            powT[i] = powT[i - 1] * local.y;
+        }
+
+        for (int m = 0; m < NUM_MONOMIALS; m++)
+        {
+            Vec3 coeff;
+            const Float* const row = &node->m_coeffs[m * numControls];
+            for (std::size_t j = 0; j < numControls; j++)
+            {
+                coeff += row[j] * mesh.getVertex(patch->m_controls[j]).m_position;
+            }
+
+            position += coeff * (powS[p[m]] * powT[q[m]]);
+            if (p[m] > 0)
+            {
+                ds += coeff * (p[m] * powS[p[m] - 1] * powT[q[m]]);
+            }
+            if (q[m] > 0)
+            {
+                dt += coeff * (q[m] * powS[p[m]] * powT[q[m] - 1]);
+            }
+        }
+    }
+    else
+    {
+        // deeper than we go, interpolate the limit points of the corners:
+        Vec3 corners[3];
+        for (int c = 0; c < 3; c++)
+        {
+            const Float* const row = &node->m_coeffs[c * numControls];
+            for (std::size_t j = 0; j < numControls; j++)
+            {
+                corners[c] += row[j] * mesh.getVertex(patch->m_controls[j]).m_position;
+            }
+        }
+
+        ds = corners[1] - corners[0];
+        dt = corners[2] - corners[0];
+        position = corners[0] + local.x * ds + local.y * dt;
+    }
+
+    // back to the (u, v) of the face:
+    const Vec3 du = ds * inv[0] + dt * inv[2];
+    const Vec3 dv = ds * inv[1] + dt * inv[3];
+
+    *o_position = position;
+    if (o_normal)
+    {
+        *o_normal = glm::normalize(glm::cross(du, dv));
+    }
+    if (o_du)
+    {
+        *o_du = du;
+    }
+    if (o_dv)
+    {
+        *o_dv = dv;
+    }
+}
+
+bool ee::LimitSurface::intersect(const MeshSnapshot& mesh, const Ray ray, std::size_t face, Float u, Float v, LimitHit* const o_hit) const
+{
+    Vec3 position, normal, du, dv;
+    evaluate(mesh, face, u, v, &position, &normal);
+    Float t = glm::dot(position - ray.m_origin, ray.m_dir) / glm::dot(ray.m_dir, ray.m_dir);
+
+    int faceChanges = 0;
+    for (int iter = 0; iter < MAX_NEWTON_ITERATIONS; iter++)
+    {
+        evaluate(mesh, face, u, v, &position, &normal, &du, &dv);
+        const Vec3 residual = position - (ray.m_origin + t * ray.m_dir);
+        if (glm::length2(residual) < NEWTON_TOLERANCE * NEWTON_TOLERANCE)
+        {
+            if (t <= 0.0)
+            {
+                return false;
+            }
+
+            o_hit->m_face = face;
+            o_hit->m_u = u;
+            o_hit->m_v = v;
+            o_hit->m_t = t;
+            o_hit->m_position = position;
+            o_hit->m_normal = normal;
+            return true;
+        }
+
+        const glm::tmat3x3<Float> jacobian(du, dv, -ray.m_dir);
+        if (std::abs(glm::determinant(jacobian)) < PARAM_EPS * PARAM_EPS)
+        {
+            return false;
+        }
+
+        const Vec3 delta = glm::inverse(jacobian) * -residual;
+        u += delta.x;
+        v += delta.y;
+        t += delta.z;
+
+        // walk over to the neighbouring face if we left this one:
+        const Float w = 1.0 - u - v;
+        if (u < 0.0 || v < 0.0 || w < 0.0)
+        {
+            const int edge = (v <= u && v <= w) ? 0 : (w <= u ? 1 : 2);
+            if (faceChanges < MAX_FACE_CHANGES)
+            {
+                const int edgeID = m_topology.getFaceEdge(face, edge);
+                const std::size_t f0 = m_topology.getEdgeFace(edgeID, 0);
+                face = f0 == face ? m_topology.getEdgeFace(edgeID, 1) : f0;
+                faceChanges++;
+
+                const MeshFace& f = mesh.getMeshFace(face);
+                controlBaryCentric(ray.m_origin + t * ray.m_dir, mesh.getVertex(f(0)).m_position,
+                    mesh.getVertex(f(1)).m_position, mesh.getVertex(f(2)).m_position, &u, &v);
+            }
+
+            u = glm::clamp(u, 0.0, 1.0);
+            v = glm::clamp(v, 0.0, 1.0 - u);
+        }
+    }
+
+    return false;
+}
+
+const ee::Mesh* ee::LimitSurface::getMesh() const
+{
+    return m_mesh;
+}
+
+const ee::LimitSurface::PatchNode* ee::LimitSurface::findNode(const std::size_t face, const Vec2 param, const FacePatch** const o_patch) const
+{
+    *o_patch = m_patches[face].get();
+
+    // go down to the (regular) sub-patch that holds the param:
+    const PatchNode* node = m_patches[face]->m_root.get();
+    while (!node->m_regular && node->m_depth < MAX_PATCH_DEPTH)
+    {
+        Float inv[4];
+        const Vec2 local = toLocal(node->m_corners, param, inv);
+        if (local.x + local.y <= 0.5)
+        {
+            node = node->m_children[0].get();
+        }
+        else if (local.x >= 0.5)
+        {
+            node = node->m_children[1].get();
+        }
+        else if (local.y >= 0.5)
+        {
+            node = node->m_children[2].get();
+        }
+        else
+        {
+            node = node->m_children[3].get();
+        }
+    }
+    return node;
+}
+
+void ee::LimitSurface::buildFacePatch(const std::size_t face, FacePatch* const o_patch) const
+{
+    const MeshFace& rootFace = m_mesh->getMeshFace(face);
+
+    // the one-ring of the face, the faces around its corners:
+    std::vector<int> ringFaces;
+    for (int k = 0; k < 3; k++)
+    {
+        ringFaces.insert(ringFaces.end(), m_vertexFaces.begin() + m_vertexFaceStart[rootFace(k)],
+            m_vertexFaces.begin() + m_vertexFaceStart[rootFace(k) + 1]);
+    }
+    std::sort(ringFaces.begin(), ringFaces.end());
+    ringFaces.erase(std::unique(ringFaces.begin(), ringFaces.end()), ringFaces.end());
+
+    std::vector<int>& controls = o_patch->m_controls;
+    for (int f : ringFaces)
+    {
+        const MeshFace& ringFace = m_mesh->getMeshFace(f);
+        controls.push_back(ringFace(0));
+        controls.push_back(ringFace(1));
+        controls.push_back(ringFace(2));
+    }
+    std::sort(controls.begin(), controls.end());
+    controls.erase(std::unique(controls.begin(), controls.end()), controls.end());
+
+    auto localID = [&controls](const int vertexID)
+    {
+        return static_cast<int>(std::lower_bound(controls.begin(), controls.end(), vertexID) - controls.begin());
+    };
+
+    PatchNode* const root = new PatchNode();
+    o_patch->m_root.reset(root);
+
+    LocalMesh& local = root->m_local;
+    local.m_numControls = controls.size();
+    local.m_weights.assign(controls.size() * controls.size(), 0.0);
+    local.m_params.assign(controls.size(), Vec2(INVALID_PARAM, INVALID_PARAM));
+    for (std::size_t i = 0; i < controls.size(); i++)
+    {
+        local.m_weights[i * controls.size() + i] = 1.0;
+    }
+    for (int f : ringFaces)
+    {
+        const MeshFace& ringFace = m_mesh->getMeshFace(f);
+        local.m_faces.push_back(MeshFace(localID(ringFace(0)), localID(ringFace(1)), localID(ringFace(2))));
+    }
+
+    root->m_corners[0] = Vec2(0.0, 0.0);
+    root->m_corners[1] = Vec2(1.0, 0.0);
+    root->m_corners[2] = Vec2(0.0, 1.0);
+    root->m_depth = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        root->m_localCorners[k] = localID(rootFace(k));
+        local.m_params[root->m_localCorners[k]] = root->m_corners[k];
+    }
+
+    initNode(root);
+}
+
+void ee::LimitSurface::buildChildren(PatchNode* const node) const
+{
+    if (node->m_regular || node->m_depth >= MAX_PATCH_DEPTH)
+    {
+        return;
+    }
+
+    splitNode(node);
+    for (int c = 0; c < 4; c++)
+    {
+        buildChildren(node->m_children[c].get());
+    }
+}
+
+void ee::LimitSurface::initNode(PatchNode* const node) const
+{
+    SubdivisionTopology topology;
+    topology.build(node->m_local.getNumVertices(), node->m_local.m_faces);
+
+    node->m_regular = true;
+    for (int k = 0; k < 3; k++)
+    {
+        node->m_regular = node->m_regular && topology.getValence(node->m_localCorners[k]) == 6;
+    }
+
+    if (node->m_regular)
+    {
+        fitRegular(node->m_local, node->m_localCorners, &node->m_coeffs);
+        node->m_local = LocalMesh(); // not needed anymore
+    }
+    else
+    {
+        const std::size_t numControls = node->m_local.m_numControls;
+        node->m_coeffs.resize(3 * numControls);
+        for (int k = 0; k < 3; k++)
+        {
+            limitRow(node->m_local, topology, node->m_localCorners[k], &node->m_coeffs[k * numControls]);
+        }
+    }
+}
+
+void ee::LimitSurface::splitNode(PatchNode* const node) const
+{
+    SubdivisionTopology topology;
+    LocalMesh refined;
+    subdivideLocal(node->m_local, &topology, &refined);
+
+    const Vec2* const p = node->m_corners;
+    const Vec2 m01 = 0.5 * (p[0] + p[1]);
+    const Vec2 m12 = 0.5 * (p[1] + p[2]);
+    const Vec2 m20 = 0.5 * (p[2] + p[0]);
+
+    // the same orientation as the parent, the corner children first and then the middle one:
+    const Vec2 childCorners[4][3] =
+    {
+        {p[0], m01, m20},
+        {m01, p[1], m12},
+        {m20, m12, p[2]},
+        {m01, m12, m20}
+    };
+
+    for (int c = 0; c < 4; c++)
+    {
+        PatchNode* const child = new PatchNode();
+        node->m_children[c].reset(child);
+        child->m_depth = node->m_depth + 1;
+
+        int corners[3];
+        for (int k = 0; k < 3; k++)
+        {
+            child->m_corners[k] = childCorners[c][k];
+            corners[k] = findVertex(refined, childCorners[c][k]);
+        }
+
+        extractOneRing(refined, corners, &child->m_local, child->m_localCorners);
+        initNode(child);
+    }
+
+    node->m_local = LocalMesh(); // the children have all that is needed
+}
+
+void ee::LimitSurface::fitRegular(const LocalMesh& local, const int corners[3], std::vector<Float>* const o_coeffs) const
+{
+    // twice subdivided, the dyadic points of the patch and their rings are exact:
+    SubdivisionTopology topology;
+    LocalMesh once, twice;
+    subdivideLocal(local, &topology, &once);
+    subdivideLocal(once, &topology, &twice);
+    topology.build(twice.getNumVertices(), twice.m_faces);
+
+    int p[NUM_MONOMIALS], q[NUM_MONOMIALS];
+    monomialExponents(p, q);
+
+    const Vec2 c0 = local.m_params[corners[0]];
+    const Vec2 e0 = local.m_params[corners[1]] - c0;
+    const Vec2 e1 = local.m_params[corners[2]] - c0;
+
+    const std::size_t numControls = local.m_numControls;
+    std::vector<Float> samples(NUM_MONOMIALS * numControls);
+    for (int k = 0; k < NUM_MONOMIALS; k++)
+    {
+        const int vertex = findVertex(twice, c0 + (p[k] / 4.0) * e0 + (q[k] / 4.0) * e1);
+        limitRow(twice, topology, vertex, &samples[k * numControls]);
+    }
+
+    o_coeffs->assign(NUM_MONOMIALS * numControls, 0.0);
+    for (int m = 0; m < NUM_MONOMIALS; m++)
+    {
+        for (int k = 0; k < NUM_MONOMIALS; k++)
+        {
+            const Float weight = m_vandermondeInv[m * NUM_MONOMIALS + k];
+            for (std::size_t j = 0; j < numControls; j++)
+            {
+                (*o_coeffs)[m * numControls + j] += weight * samples[k * numControls + j];
+            }
+        }
+    }
+}
+
+void ee::LimitSurface::subdivideLocal(const LocalMesh& local, SubdivisionTopology* const topology, LocalMesh* const o_result)
+{
+    topology->build(local.getNumVertices(), local.m_faces);
+
+    const std::size_t numControls = local.m_numControls;
+    o_result->m_numControls = numControls;
+    o_result->m_weights.assign(topology->getNumRefinedVertices() * numControls, 0.0);
+    o_result->m_params.resize(topology->getNumRefinedVertices());
+
+    for (std::size_t v = 0; v < local.getNumVertices(); v++)
+    {
+        const std::size_t n = topology->getValence(v);
+        const Float beta = n > 0 ? SubdivisionTopology::betaConst(n) : 0.0;
+
+        Float* const out = &o_result->m_weights[v * numControls];
+        const Float* const self = &local.m_weights[v * numControls];
+        for (std::size_t j = 0; j < numControls; j++)
+        {
+            out[j] = (1.0 - beta * n) * self[j];
+        }
+        for (const int* it = topology->getRingBegin(v); it != topology->getRingEnd(v); ++it)
+        {
+            const Float* const ring = &local.m_weights[*it * numControls];
+            for (std::size_t j = 0; j < numControls; j++)
+            {
+                out[j] += beta * ring[j];
+            }
+        }
+        o_result->m_params[v] = local.m_params[v];
+    }
+
+    for (std::size_t e = 0; e < topology->getNumEdges(); e++)
+    {
+        const int a = topology->getEdgeVertex(e, 0);
+        const int b = topology->getEdgeVertex(e, 1);
+        const bool interior = topology->isInteriorEdge(e);
+
+        // the edges on the border of the local mesh are wrong, but they are outside of the patch anyway
+        Float* const out = &o_result->m_weights[topology->getEdgePoint(e) * numControls];
+        const Float edgeWeight = interior ? 3.0 / 8.0 : 0.5;
+        for (std::size_t j = 0; j < numControls; j++)
+        {
+            out[j] = edgeWeight * (local.m_weights[a * numControls + j] + local.m_weights[b * numControls + j]);
+        }
+        if (interior)
+        {
+            for (std::size_t i = 0; i < 2; i++)
+            {
+                const Float* const opposite = &local.m_weights[topology->getOppositeVertex(local.m_faces, e, i) * numControls];
+                for (std::size_t j = 0; j < numControls; j++)
+                {
+                    out[j] += 1.0 / 8.0 * opposite[j];
+                }
+            }
+        }
+
+        const Vec2& pa = local.m_params[a];
+        const Vec2& pb = local.m_params[b];
+        o_result->m_params[topology->getEdgePoint(e)] = isValidParam(pa) && isValidParam(pb) ? 0.5 * (pa + pb) : Vec2(INVALID_PARAM, INVALID_PARAM);
+    }
+
+    topology->buildRefinedFaces(local.m_faces, &o_result->m_faces);
+}
+
+void ee::LimitSurface::extractOneRing(const LocalMesh& local, const int corners[3], LocalMesh* const o_result, int o_corners[3])
+{
+    const std::size_t numControls = local.m_numControls;
+    std::vector<int> newIDs(local.getNumVertices(), -1);
+
+    o_result->m_numControls = numControls;
+    o_result->m_weights.clear();
+    o_result->m_params.clear();
+    o_result->m_faces.clear();
+
+    auto mapVertex = [&](const int v)
+    {
+        if (newIDs[v] < 0)
+        {
+            newIDs[v] = static_cast<int>(o_result->m_params.size());
+            o_result->m_params.push_back(local.m_params[v]);
+            o_result->m_weights.insert(o_result->m_weights.end(), local.m_weights.begin() + v * numControls,
+                local.m_weights.begin() + (v + 1) * numControls);
+        }
+        return newIDs[v];
+    };
+
+    for (const MeshFace& face : local.m_faces)
+    {
+        bool touches = false;
+        for (int k = 0; k < 3; k++)
+        {
+            touches = touches || face(k) == corners[0] || face(k) == corners[1] || face(k) == corners[2];
+        }
+
+        if (touches)
+        {
+            const int a = mapVertex(face(0));
+            const int b = mapVertex(face(1));
+            const int c = mapVertex(face(2));
+            o_result->m_faces.push_back(MeshFace(a, b, c));
+        }
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        o_corners[k] = newIDs[corners[k]];
+    }
+}
+
+int ee::LimitSurface::findVertex(const LocalMesh& local, const Vec2 param)
+{
+    for (std::size_t v = 0; v < local.getNumVertices(); v++)
+    {
+        if (std::abs(local.m_params[v].x - param.x) < PARAM_EPS && std::abs(local.m_params[v].y - param.y) < PARAM_EPS)
+        {
+            return static_cast<int>(v);
+        }
+    }
+
+    throw std::logic_error("The limit surface patch is missing a subdivided vertex.");
+}
+
+void ee::LimitSurface::limitRow(const LocalMesh& local, const SubdivisionTopology& topology, const int vertex, Float* const o_row)
+{
+    // limit mask: (1 - n * chi) * v + chi * sum(neighbours) with chi = 1 / (3 / (8 * beta) + n)
+    const std::size_t numControls = local.m_numControls;
+    const std::size_t n = topology.getValence(vertex);
+    const Float chi = 1.0 / (3.0 / (8.0 * SubdivisionTopology::betaConst(n)) + n);
+
+    const Float* const self = &local.m_weights[vertex * numControls];
+    for (std::size_t j = 0; j < numControls; j++)
+    {
+        o_row[j] = (1.0 - n * chi) * self[j];
+    }
+    for (const int* it = topology.getRingBegin(vertex); it != topology.getRingEnd(vertex); ++it)
+    {
+        const Float* const ring = &local.m_weights[*it * numControls];
+        for (std::size_t j = 0; j < numControls; j++)
+        {
+            o_row[j] += chi * ring[j];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Modeling/Mesh.hpp"
+#include "SubdivisionTopology.hpp"
+#include "../Types.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace ee
+{
+    struct LimitHit
+    {
+        std::size_t m_face;
+        Float       m_u;
+        Float       m_v;
+        Float       m_t;        // along the ray
+        Vec3        m_position;
+        Vec3        m_normal;   // follows the winding of the face
+    };
+
+    // Evaluates the loop limit surface of a closed control mesh at (face, u, v), where the point is
+    // (1 - u - v) * face(0) + u * face(1) + v * face(2) on the control triangle.
+    //
+    // A patch whose corners all have valence 6 is a quartic polynomial. It is found exactly by subdividing
+    // its one-ring twice and fitting the limit points (limit masks) at the 15 dyadic points. Patches with
+    // extraordinary corners are split the same way the subdivision does, down to the regular sub-patch that
+    // holds (u, v). Everything is kept as weights of the control points, so it only depends on the topology
+    // and is built (in parallel) whenever the faces change. Evaluating only reads it, so it is lock free and
+    // can be done on any number of threads. The positions are read from a snapshot of the mesh (see
+    // Mesh::getSnapshot) on every call, in model space.
+    class LimitSurface
+    {
+    public:
+        explicit LimitSurface(const Mesh* mesh);
+
+        // has to be called when the faces of the mesh change (and not while evaluating)
+        void rebuild();
+
+        // the snapshot is of the mesh with the faces of the last rebuild
+        void evaluate(const MeshSnapshot& mesh, std::size_t face, Float u, Float v, Vec3* o_position, Vec3* o_normal, Vec3* o_du = nullptr, Vec3* o_dv = nullptr) const;
+
+        // Refines a hit on the control mesh (face and u, v on the control triangle) to the limit surface with
+        // Newton steps, crossing to neighbouring faces if needed. The ray is in model space.
+        bool intersect(const MeshSnapshot& mesh, Ray ray, std::size_t face, Float u, Float v, LimitHit* o_hit) const;
+
+        const Mesh* getMesh() const;
+
+    private:
+        struct LocalMesh
+        {
+            std::size_t             m_numControls;  // columns of the weights
+            std::vector<Float>      m_weights;      // one row of control point weights per vertex
+            std::vector<Vec2>       m_params;       // (u, v) of the root face, only valid on the root face
+            std::vector<MeshFace>   m_faces;
+
+            std::size_t getNumVertices() const { return m_params.size(); }
+        };
+
+        struct PatchNode
+        {
+            Vec2                        m_corners[3];   // params of the corners of the (sub-)patch
+            int                         m_depth;
+            bool                        m_regular;
+            std::vector<Float>          m_coeffs;       // regular: monomial coefficients, else corner limit points (3 rows)
+            LocalMesh                   m_local;        // one-ring of the patch, only kept if it isn't regular
+            int                         m_localCorners[3];
+            std::unique_ptr<PatchNode>  m_children[4];
+        };
+
+        struct FacePatch
+        {
+            std::vector<int>            m_controls;     // global vertex IDs of the columns
+            std::unique_ptr<PatchNode>  m_root;
+        };
+
+        const PatchNode* findNode(std::size_t face, Vec2 param, const FacePatch** o_patch) const;
+        void buildFacePatch(std::size_t face, FacePatch* o_patch) const;
+        void buildChildren(PatchNode* node) const; // splits the node down to the regular sub-patches
+        void initNode(PatchNode* node) const;
+        void splitNode(PatchNode* node) const;
+        void fitRegular(const LocalMesh& local, const int corners[3], std::vector<Float>* o_coeffs) const;
+
+        static void subdivideLocal(const LocalMesh& local, SubdivisionTopology* topology, LocalMesh* o_result);
+        static void extractOneRing(const LocalMesh& local, const int corners[3], LocalMesh* o_result, int o_corners[3]);
+        static int findVertex(const LocalMesh& local, Vec2 param);
+        static void limitRow(const LocalMesh& local, const SubdivisionTopology& topology, int vertex, Float* o_row);
+
+        const Mesh* const                       m_mesh;
+        SubdivisionTopology                     m_topology;
+        std::vector<std::size_t>                m_vertexFaceStart; // faces around every vertex, in CSR form
+        std::vector<int>                        m_vertexFaces;
+        Float                                   m_vandermondeInv[15 * 15];
+
+        std::vector<std::unique_ptr<FacePatch>> m_patches;
+    };
+}
\ No newline at end of file
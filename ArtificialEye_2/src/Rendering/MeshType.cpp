@@ -1,6 +1,7 @@
 #include "MeshTypes.hpp"
 
 #include <cmath>
+#include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
 
@@ -93,15 +94,15 @@ namespace icosphere
     /// Helper Function:
     ////////////////////
 
-    std::unordered_map<uint64_t, GLuint> g_cachedMiddlePoints;
-    int getMiddlePoint(int i0, int i1, std::vector<ee::Vertex>* list)
+    // middle points are shared by the two faces of an edge, the cache is keyed on the edge
+    int getMiddlePoint(int i0, int i1, std::vector<ee::Vertex>* list, std::unordered_map<uint64_t, GLuint>* cache)
     {
         uint64_t minInd = static_cast<uint64_t>(std::min(i0, i1));
         uint64_t maxInd = static_cast<uint64_t>(std::max(i0, i1));
         uint64_t key = (minInd << 32) + maxInd;
 
-        auto it = g_cachedMiddlePoints.find(key);
-        if (it != g_cachedMiddlePoints.end())
+        auto it = cache->find(key);
+        if (it != cache->end())
         {
             return it->second;
         }
@@ -111,7 +112,7 @@ namespace icosphere
         ee::Vec3 m = glm::normalize((p0 + p1) * 0.5);
 
         list->push_back(m);
-        g_cachedMiddlePoints.insert(std::make_pair(key, list->size() - 1));
+        cache->insert(std::make_pair(key, list->size() - 1));
         return list->size() - 1;
     }
 }
@@ -139,25 +140,30 @@ ee::Mesh ee::loadIndexedCube()
 
 ee::Mesh ee::loadIcosphere(unsigned recursionLevel)
 {
-    icosphere::g_cachedMiddlePoints.clear();
     std::vector<Vertex> vertList = icosphere::VERTICES;
     std::vector<MeshFace> indexList = icosphere::INDICES;
 
     for (int i = 0; i < recursionLevel; i++)
     {
+        // the middle points of this level, every edge is shared by two faces:
+        std::unordered_map<uint64_t, GLuint> middlePoints;
+        middlePoints.reserve(indexList.size() * 3 / 2);
+        vertList.reserve(vertList.size() + indexList.size() * 3 / 2);
+
         std::vector<MeshFace> tempIndList1;
+        tempIndList1.reserve(indexList.size() * 4);
         for (const MeshFace& face : indexList)
         {
-            int i0 = icosphere::getMiddlePoint(face(0), face(1), &vertList);
-            int i1 = icosphere::getMiddlePoint(face(1), face(2), &vertList);
-            int i2 = icosphere::getMiddlePoint(face(2), face(0), &vertList);
+            int i0 = icosphere::getMiddlePoint(face(0), face(1), &vertList, &middlePoints);
+            int i1 = icosphere::getMiddlePoint(face(1), face(2), &vertList, &middlePoints);
+            int i2 = icosphere::getMiddlePoint(face(2), face(0), &vertList, &middlePoints);
 
             tempIndList1.push_back({face(0), i0, i2});
             tempIndList1.push_back({face(1), i1, i0});
             tempIndList1.push_back({face(2), i2, i1});
             tempIndList1.push_back({i0, i1, i2});
         }
-        indexList = tempIndList1;
+        indexList = std::move(tempIndList1);
     }
 
     return Mesh(vertList, indexList, MeshType::ICOSPHERE);
@@ -0,0 +1,244 @@
+#include "CompactMesh.hpp"
+#include "../../Parallel.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const std::size_t COMPRESS_GRAIN    = 4096;
+    const float       SNORM16_SCALE     = 32767.0f;
+
+    ee::Float signNotZero(const ee::Float value)
+    {
+        return value >= 0.0 ? 1.0 : -1.0;
+    }
+
+    int16_t toSnorm16(const ee::Float value)
+    {
+        return static_cast<int16_t>(std::floor(glm::clamp(value, -1.0, 1.0) * SNORM16_SCALE + 0.5));
+    }
+}
+
+void ee::encodeOctNormal(const Vec3& normal, int16_t o_encoded[2])
+{
+    const Float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 == 0.0)
+    {
+        o_encoded[0] = o_encoded[1] = 0;
+        return;
+    }
+
+    // project onto the octahedron, the lower half is folded over the diagonals:
+    Vec2 p = Vec2(normal.x, normal.y) / l1;
+    if (normal.z < 0.0)
+    {
+        p = Vec2((1.0 - std::abs(p.y)) * signNotZero(p.x), (1.0 - std::abs(p.x)) * signNotZero(p.y));
+    }
+
+    o_encoded[0] = toSnorm16(p.x);
+    o_encoded[1] = toSnorm16(p.y);
+}
+
+ee::Vec3 ee::decodeOctNormal(const int16_t encoded[2])
+{
+    const Vec2 p(glm::max(encoded[0] / Float(SNORM16_SCALE), -1.0), glm::max(encoded[1] / Float(SNORM16_SCALE), -1.0));
+    Vec3 v(p.x, p.y, 1.0 - std::abs(p.x) - std::abs(p.y));
+    if (v.z < 0.0)
+    {
+        v = Vec3((1.0 - std::abs(p.y)) * signNotZero(p.x), (1.0 - std::abs(p.x)) * signNotZero(p.y), v.z);
+    }
+
+    const Float length = glm::length(v);
+    return length > 0.0 ? v / length : Vec3();
+}
+
+uint16_t ee::floatToHalf(const float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu)
+    {
+        // inf or nan (keep nan a nan):
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+
+    const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 0x1f)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00u); // too large
+    }
+
+    if (halfExponent <= 0)
+    {
+        if (halfExponent < -10)
+        {
+            return static_cast<uint16_t>(sign); // too small, even for a denormal
+        }
+
+        // denormal, round to nearest:
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u)
+        {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // round to nearest, a carry into the exponent is still correct:
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u)
+    {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float ee::halfToFloat(const uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1fu;
+    const uint32_t mantissa = value & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // denormal, the value is mantissa * 2^-24:
+            const float result = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -result : result;
+        }
+    }
+    else if (exponent == 0x1fu)
+    {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+ee::CompactVertex ee::compressVertex(const Vertex& vertex)
+{
+    CompactVertex result;
+    result.m_position[0] = static_cast<float>(vertex.m_position.x);
+    result.m_position[1] = static_cast<float>(vertex.m_position.y);
+    result.m_position[2] = static_cast<float>(vertex.m_position.z);
+    encodeOctNormal(vertex.m_normal, result.m_normal);
+    result.m_textCoord[0] = floatToHalf(static_cast<float>(vertex.m_textCoord.x));
+    result.m_textCoord[1] = floatToHalf(static_cast<float>(vertex.m_textCoord.y));
+    return result;
+}
+
+ee::Vertex ee::decompressVertex(const CompactVertex& vertex)
+{
+    Vertex result;
+    result.m_position = Vec3(vertex.m_position[0], vertex.m_position[1], vertex.m_position[2]);
+    result.m_normal = decodeOctNormal(vertex.m_normal);
+    result.m_textCoord = Vec2(halfToFloat(vertex.m_textCoord[0]), halfToFloat(vertex.m_textCoord[1]));
+    return result;
+}
+
+ee::CompactMesh::CompactMesh() :
+    m_numIndices(0),
+    m_shortIndices(true)
+{
+}
+
+ee::CompactMesh::CompactMesh(const Mesh& mesh) :
+    m_numIndices(0),
+    m_shortIndices(true)
+{
+    updateVertices(mesh.getVerticesData());
+    updateMeshFaces(mesh.getMeshFaceData());
+}
+
+void ee::CompactMesh::updateVertices(const std::vector<Vertex>& vertices)
+{
+    m_vertices.resize(vertices.size());
+    CompactVertex* const out = m_vertices.data();
+    parallelFor(0, vertices.size(), [&vertices, out](const std::size_t i)
+    {
+        out[i] = compressVertex(vertices[i]);
+    }, COMPRESS_GRAIN);
+}
+
+void ee::CompactMesh::updateMeshFaces(const std::vector<MeshFace>& faces)
+{
+    // the largest index decides, not the number of vertices (that could change first):
+    int maxIndex = 0;
+    for (const MeshFace& face : faces)
+    {
+        maxIndex = std::max(maxIndex, std::max(face(0), std::max(face(1), face(2))));
+    }
+
+    m_numIndices = faces.size() * 3;
+    m_shortIndices = maxIndex <= 0xffff;
+    if (m_shortIndices)
+    {
+        m_indices32.clear();
+        m_indices16.resize(m_numIndices);
+        for (std::size_t f = 0; f < faces.size(); f++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                m_indices16[3 * f + k] = static_cast<uint16_t>(faces[f](k));
+            }
+        }
+    }
+    else
+    {
+        m_indices16.clear();
+        m_indices32.resize(m_numIndices);
+        std::memcpy(m_indices32.data(), faces.data(), m_numIndices * sizeof(uint32_t));
+    }
+}
+
+ee::Mesh ee::CompactMesh::decompress() const
+{
+    std::vector<Vertex> vertices(m_vertices.size());
+    for (std::size_t i = 0; i < m_vertices.size(); i++)
+    {
+        vertices[i] = decompressVertex(m_vertices[i]);
+    }
+
+    std::vector<MeshFace> faces(m_numIndices / 3);
+    for (std::size_t f = 0; f < faces.size(); f++)
+    {
+        faces[f] = MeshFace(static_cast<int>(getVertexID(3 * f)), static_cast<int>(getVertexID(3 * f + 1)), static_cast<int>(getVertexID(3 * f + 2)));
+    }
+
+    return Mesh(std::move(vertices), std::move(faces));
+}
+
+const void* ee::CompactMesh::getIndexData() const
+{
+    return m_shortIndices ? static_cast<const void*>(m_indices16.data()) : static_cast<const void*>(m_indices32.data());
+}
+
+std::size_t ee::CompactMesh::getIndexDataSize() const
+{
+    return m_numIndices * (m_shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+std::size_t ee::CompactMesh::getVertexID(const std::size_t indexID) const
+{
+    return m_shortIndices ? m_indices16[indexID] : m_indices32[indexID];
+}
\ No newline at end of file
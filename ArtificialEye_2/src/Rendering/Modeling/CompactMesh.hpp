@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Mesh.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+namespace ee
+{
+    // 20 bytes instead of the 64 of a Vertex. The position is a float, the normal is octahedral encoded
+    // (the unit sphere folded onto a square) in two signed normalized shorts and the texture coordinates
+    // are half floats.
+    struct CompactVertex
+    {
+        float       m_position[3];
+        int16_t     m_normal[2];
+        uint16_t    m_textCoord[2];
+    };
+    static_assert(sizeof(CompactVertex) == 20, "CompactVertex can't have any padding");
+
+    void encodeOctNormal(const Vec3& normal, int16_t o_encoded[2]);
+    Vec3 decodeOctNormal(const int16_t encoded[2]);
+
+    uint16_t floatToHalf(float value);
+    float halfToFloat(uint16_t value);
+
+    CompactVertex compressVertex(const Vertex& vertex);
+    Vertex decompressVertex(const CompactVertex& vertex);
+
+    // Compact copy of a mesh for storage and drawing, the indices are 16 bit if every vertex fits. The double
+    // precision Mesh stays the working set of the numerical code (simulation, subdivision, tracing).
+    class CompactMesh
+    {
+    public:
+        CompactMesh();
+        explicit CompactMesh(const Mesh& mesh);
+
+        // the vertices are compressed in parallel
+        void updateVertices(const std::vector<Vertex>& vertices);
+        void updateMeshFaces(const std::vector<MeshFace>& faces);
+
+        Mesh decompress() const;
+
+        const std::vector<CompactVertex>& getVertices() const { return m_vertices; }
+        std::size_t getNumVertices() const { return m_vertices.size(); }
+        std::size_t getNumIndices() const { return m_numIndices; }
+
+        bool hasShortIndices() const { return m_shortIndices; }
+        GLenum getIndexType() const { return m_shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+        const void* getIndexData() const;
+        std::size_t getIndexDataSize() const;
+        std::size_t getVertexID(std::size_t indexID) const;
+
+    private:
+        std::vector<CompactVertex>  m_vertices;
+        std::vector<uint16_t>       m_indices16;
+        std::vector<uint32_t>       m_indices32;
+        std::size_t                 m_numIndices;
+        bool                        m_shortIndices;
+    };
+}
\ No newline at end of file
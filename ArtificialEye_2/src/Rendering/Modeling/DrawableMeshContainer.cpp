@@ -5,13 +5,14 @@
 ee::DrawableMeshContainer::DrawableMeshContainer(const Mesh* const mesh, const std::string& textPack, const bool dynamic, const int priority) :
     Drawable(textPack, priority), 
     m_mesh(mesh),
-    m_updateCount(0),
+    m_updateCount(mesh->getUpdateCount()),
+    m_topologyCount(mesh->getTopologyCount()),
     m_type(dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW)
 {
-    const std::vector<Vertex>& updatedVertices = m_mesh->getVerticesData();
-    const std::vector<MeshFace>& updatedMeshFaces = m_mesh->getMeshFaceData();
-    castVertexBuffer(updatedVertices);
-    m_cachedMeshFaces.insert(m_cachedMeshFaces.end(), updatedMeshFaces.begin(), updatedMeshFaces.end());
+    const VertexBuffer vertices = m_mesh->getVertexBuffer();
+    const FaceBuffer faces = m_mesh->getFaceBuffer();
+    m_compactMesh.updateVertices(*vertices);
+    m_compactMesh.updateMeshFaces(*faces);
 
     glGenVertexArrays(1, &m_VAO);
     glGenBuffers(1, &m_VBO);
@@ -20,17 +21,18 @@ ee::DrawableMeshContainer::DrawableMeshContainer(const Mesh* const mesh, const s
     glBindVertexArray(m_VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(FloatVertex) * m_cachedVertices.size(), m_cachedVertices.data(), m_type);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CompactVertex) * m_compactMesh.getNumVertices(), m_compactMesh.getVertices().data(), m_type);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(MeshFace) * m_cachedMeshFaces.size(), m_cachedMeshFaces.data(), m_type);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_compactMesh.getIndexDataSize(), m_compactMesh.getIndexData(), m_type);
 
+    // the normal is octahedral encoded (see decodeOctNormal in the vertex shaders):
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(FloatVertex), (void*)offsetof(FloatVertex, m_position));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, m_position));
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(FloatVertex), (void*)offsetof(FloatVertex, m_normal));
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, m_normal));
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(FloatVertex), (void*)offsetof(FloatVertex, m_textCoord));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, m_textCoord));
 
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -44,21 +46,35 @@ void ee::DrawableMeshContainer::draw()
     {
         m_updateCount = m_mesh->getUpdateCount();
 
-        const std::vector<Vertex>& updatedVertices = m_mesh->getVerticesData();
-        const std::vector<MeshFace>& updatedMeshFaces = m_mesh->getMeshFaceData();
-        castVertexBuffer(updatedVertices);
-
-        // No point in updating this because it is likely not to be updated
-        // m_cachedMeshFaces.insert(m_cachedMeshFaces.end(), updatedMeshFaces.begin(), updatedMeshFaces.end());
+        const VertexBuffer vertices = m_mesh->getVertexBuffer();
+        const std::size_t prevNumVertices = m_compactMesh.getNumVertices();
+        m_compactMesh.updateVertices(*vertices);
 
         // update the vertices
+        const std::size_t vertexDataSize = m_compactMesh.getNumVertices() * sizeof(CompactVertex);
         glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, m_cachedVertices.size() * sizeof(FloatVertex), m_cachedVertices.data());
+        if (prevNumVertices == m_compactMesh.getNumVertices())
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertexDataSize, m_compactMesh.getVertices().data());
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER, vertexDataSize, m_compactMesh.getVertices().data(), m_type);
+        }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        /*glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_cachedMeshFaces.size() * sizeof(MeshFace), m_cachedMeshFaces.data());
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);*/
+        // the faces rarely change, only convert and upload them when they did:
+        if (m_topologyCount != m_mesh->getTopologyCount())
+        {
+            m_topologyCount = m_mesh->getTopologyCount();
+
+            const FaceBuffer faces = m_mesh->getFaceBuffer();
+            m_compactMesh.updateMeshFaces(*faces);
+            glBindVertexArray(m_VAO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_compactMesh.getIndexDataSize(), m_compactMesh.getIndexData(), m_type);
+            glBindVertexArray(0);
+        }
     }
 
     glBindVertexArray(m_VAO);
@@ -79,22 +95,9 @@ void ee::DrawableMeshContainer::draw()
     Drawable::m_shader->assignMat4("u_posTrans", trans);
     Drawable::m_shader->assignMat4("u_model", modelTrans); // in case this is needed
 
-    glDrawElements(GL_TRIANGLES, m_mesh->getNumIndices(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_compactMesh.getNumIndices()), m_compactMesh.getIndexType(), 0);
 
     glBindVertexArray(0);
 
     m_texturePack->postDraw();
-}
-
-void ee::DrawableMeshContainer::castVertexBuffer(const std::vector<Vertex>& vertices)
-{
-    m_cachedVertices.clear();
-    for (auto vert : vertices)
-    {
-        FloatVertex vertex;
-        vertex.m_normal = glm::vec3(vert.m_normal);
-        vertex.m_position = glm::vec3(vert.m_position);
-        vertex.m_textCoord = glm::vec2(vert.m_textCoord);
-        m_cachedVertices.push_back(vertex);
-    }
 }
\ No newline at end of file
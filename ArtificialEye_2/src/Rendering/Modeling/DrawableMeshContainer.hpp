@@ -2,7 +2,7 @@
 
 #include "../Drawable.hpp"
 #include "../Textures/Texture.hpp"
-#include "Mesh.hpp"
+#include "CompactMesh.hpp"
 
 namespace ee
 {
@@ -24,13 +24,12 @@ namespace ee
     private:
         const Mesh* const m_mesh;
 
-        std::vector<FloatVertex> m_cachedVertices;
-        std::vector<MeshFace> m_cachedMeshFaces;
+        CompactMesh m_compactMesh; // what is uploaded, 20 bytes per vertex and 16 bit indices if possible
         std::vector<Texture> m_textures;
 
+        // versions of the mesh that were uploaded last
         long long unsigned m_updateCount;
-
-        void castVertexBuffer(const std::vector<Vertex>& vertices);
+        long long unsigned m_topologyCount;
 
 
         GLenum m_type;
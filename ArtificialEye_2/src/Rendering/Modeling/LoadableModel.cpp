@@ -2,28 +2,25 @@
 
 #include <iostream>
 
+#include "MeshOptimizer.hpp"
 #include "../Subdivision.hpp"
 #include "../../Initialization.hpp"
 
 int ee::LoadableModel::m_numModel = 0;
 
-const int corneaVertexCount = 352;
-const int pupilVertexCount = 224;
-// 224 pupil
-// 128 iris
-// 352 cornea
-// 1632
+const unsigned IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals;
 
-void ee::LoadableModel::load()
-{
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(m_dir, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+// The meshes of the eyeball are only told apart by the number of vertices Assimp gives them
+// (224 pupil, 128 iris, 352 cornea, 1632 eyeball), these are checked before they are optimized.
+const std::size_t CORNEA_SOURCE_VERTEX_COUNT = 352;
+const std::size_t PUPIL_SOURCE_VERTEX_COUNT = 224;
 
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        throw std::runtime_error(importer.GetErrorString());
-    }
+// relative to the size of each mesh
+const ee::Float WELD_TOLERANCE = 1.0e-6;
 
+void ee::LoadableModel::load()
+{
+    const std::string file = m_dir;
     auto pos = m_dir.find_last_of('/');
     if (pos == std::string::npos)
     {
@@ -34,17 +31,34 @@ void ee::LoadableModel::load()
         m_dir = m_dir.substr(0, pos) + "/";
     }
 
-    aiNode* node = scene->mRootNode;
-    bool loadCheck;
-    processNode(node, scene, &loadCheck);
-    if (!loadCheck)
+    // the cornea is subdivided while importing, so the subdivision level is part of the key:
+    const std::string cacheFile = file + ".meshcache";
+    const uint64_t cacheKey = calcMeshCacheKey(file, IMPORT_FLAGS, ARTIFICIAL_EYE_PROP.subdiv_level_cornea);
+
+    std::vector<CachedMesh> meshes;
+    if (!readMeshCache(cacheFile, cacheKey, &meshes))
     {
-        throw std::runtime_error("Issue when parsing and setting up nodes.");
+        importMeshes(file, &meshes);
+        if (!writeMeshCache(cacheFile, cacheKey, meshes))
+        {
+            std::cout << "Could not write the mesh cache " << cacheFile << std::endl;
+        }
+    }
+
+    for (auto& mesh : meshes)
+    {
+        bool loadCheck;
+        m_textures.push_back(loadTextures(mesh.m_textures, &loadCheck));
+        if (!loadCheck)
+        {
+            throw std::runtime_error("Issue when loading the textures of " + file + ".");
+        }
+        m_meshes.push_back(std::unique_ptr<Mesh>(new Mesh(std::move(mesh.m_vertices), std::move(mesh.m_faces))));
     }
 
     for (int i = 0; i < m_meshes.size(); i++)
     {
-        if (pupilVertexCount == m_meshes[i]->getNumVertices()) { continue; }
+        if (meshes[i].m_hidden) { continue; }
         m_drawables.push_back(std::unique_ptr<DrawableMeshContainer>(new DrawableMeshContainer(m_meshes[i].get(), m_textPack, false)));
         m_drawables.back()->setTexture(m_textures[i]);
     }
@@ -55,14 +69,45 @@ void ee::LoadableModel::load()
     }
 }
 
-std::vector<ee::Texture> ee::LoadableModel::loadTexture(const aiMaterial* mat, aiTextureType type, TextType typeName, bool* check)
+void ee::LoadableModel::importMeshes(const std::string& file, std::vector<CachedMesh>* o_meshes)
+{
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(file, IMPORT_FLAGS);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        throw std::runtime_error(importer.GetErrorString());
+    }
+
+    aiNode* node = scene->mRootNode;
+    bool loadCheck;
+    processNode(node, scene, o_meshes, &loadCheck);
+    if (!loadCheck)
+    {
+        throw std::runtime_error("Issue when parsing and setting up nodes.");
+    }
+}
+
+void ee::LoadableModel::addTextureNames(const aiMaterial* mat, aiTextureType type, TextType typeName, std::vector<CachedTexture>* o_textures)
 {
-    std::vector<Texture> textures;
     for (size_t i = 0; i < mat->GetTextureCount(type); i++)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
-        Texture texture(str.C_Str(), m_dir);
+
+        CachedTexture texture;
+        texture.m_name = str.C_Str();
+        texture.m_type = typeName;
+        o_textures->push_back(texture);
+    }
+}
+
+std::vector<ee::Texture> ee::LoadableModel::loadTextures(const std::vector<CachedTexture>& cached, bool* check)
+{
+    std::vector<Texture> textures;
+    for (const CachedTexture& cachedTexture : cached)
+    {
+        Texture texture(cachedTexture.m_name, m_dir);
 
         if (texture.getTexture() == 0 && check)
         {
@@ -70,7 +115,7 @@ std::vector<ee::Texture> ee::LoadableModel::loadTexture(const aiMaterial* mat, a
             return std::vector<Texture>();
         }
 
-        texture.m_type = typeName;
+        texture.m_type = cachedTexture.m_type;
         textures.push_back(texture);
     }
 
@@ -78,11 +123,11 @@ std::vector<ee::Texture> ee::LoadableModel::loadTexture(const aiMaterial* mat, a
     return textures;
 }
 
-void ee::LoadableModel::processMesh(const aiMesh* mesh, const aiScene* scene, bool* check)
+void ee::LoadableModel::processMesh(const aiMesh* mesh, const aiScene* scene, std::vector<CachedMesh>* o_meshes, bool* check)
 {
     std::vector<Vertex> tempVert;
     std::vector<MeshFace> tempInd;
-    std::vector<Texture> tempTexts;
+    std::vector<CachedTexture> tempTexts;
 
     for (size_t i = 0; i < mesh->mNumVertices; i++)
     {
@@ -120,47 +165,52 @@ void ee::LoadableModel::processMesh(const aiMesh* mesh, const aiScene* scene, bo
         }
     }
 
-    bool correctLoad;
     if (mesh->mMaterialIndex >= 0)
     {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        std::vector<Texture> diffuse = loadTexture(material, aiTextureType_DIFFUSE, TextType::DIFFUSE, &correctLoad);
-        if (!correctLoad && check)
-        {
-            *check = false;
-        }
-        tempTexts.insert(tempTexts.end(), diffuse.begin(), diffuse.end());
-
-        std::vector<Texture> specular = loadTexture(material, aiTextureType_SPECULAR, TextType::SPECULAR, &correctLoad);
-        if (!correctLoad && check)
-        {
-            *check = false;
-        }
-        tempTexts.insert(tempTexts.end(), specular.begin(), specular.end());
+        addTextureNames(material, aiTextureType_DIFFUSE, TextType::DIFFUSE, &tempTexts);
+        addTextureNames(material, aiTextureType_SPECULAR, TextType::SPECULAR, &tempTexts);
     }
 
+    const bool isCornea = tempVert.size() == CORNEA_SOURCE_VERTEX_COUNT;
+    const bool isPupil = tempVert.size() == PUPIL_SOURCE_VERTEX_COUNT;
+
+    // Assimp splits the vertices along the uv and normal seams. Only the duplicates are merged, except on
+    // the cornea, which is subdivided and has to be connected across its seams:
+    weldVertices(&tempVert, &tempInd, WELD_TOLERANCE, isCornea);
+
     // A hack, but I got to get this done now
-    if (tempVert.size() == corneaVertexCount)
+    if (isCornea)
     {
-        Mesh temp(tempVert, tempInd);
-        temp = loopSubdiv(temp, ARTIFICIAL_EYE_PROP.subdiv_level_cornea);
-        tempVert = std::move(temp.getVerticesData());
-        tempInd = std::move(temp.getMeshFaceData());
+        // straight on the arrays, without a mesh to copy them into and out of:
+        LoopSubdivWorkspace workspace;
+        std::vector<Vertex> subdivVert;
+        std::vector<MeshFace> subdivInd;
+        loopSubdiv(tempVert, tempInd, ARTIFICIAL_EYE_PROP.subdiv_level_cornea, &subdivVert, &subdivInd, &workspace);
+        tempVert.swap(subdivVert);
+        tempInd.swap(subdivInd);
     }
 
-    m_meshes.push_back(std::unique_ptr<Mesh>(new Mesh(tempVert, tempInd)));
-    m_textures.push_back(std::move(tempTexts));
+    optimizeVertexCache(&tempInd, tempVert.size());
+    optimizeVertexFetch(&tempVert, &tempInd);
+
+    CachedMesh result;
+    result.m_hidden = isPupil;
+    result.m_vertices = std::move(tempVert);
+    result.m_faces = std::move(tempInd);
+    result.m_textures = std::move(tempTexts);
+    o_meshes->push_back(std::move(result));
 
     *check = true;
 }
 
-void ee::LoadableModel::processNode(aiNode* node, const aiScene* scene, bool* check)
+void ee::LoadableModel::processNode(aiNode* node, const aiScene* scene, std::vector<CachedMesh>* o_meshes, bool* check)
 {
     bool correctLoad;
     for (size_t i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh, scene, &correctLoad);
+        processMesh(mesh, scene, o_meshes, &correctLoad);
         if (!correctLoad && check)
         {
             *check = false;
@@ -169,7 +219,7 @@ void ee::LoadableModel::processNode(aiNode* node, const aiScene* scene, bool* ch
 
     for (size_t i = 0; i < node->mNumChildren; i++)
     {
-        processNode(node->mChildren[i], scene, &correctLoad);
+        processNode(node->mChildren[i], scene, o_meshes, &correctLoad);
         if (!correctLoad && check)
         {
             *check = false;
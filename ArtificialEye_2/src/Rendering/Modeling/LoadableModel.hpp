@@ -8,6 +8,7 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.hpp"
+#include "MeshCache.hpp"
 #include "DrawableMeshContainer.hpp"
 #include "../Textures/Texture.hpp"
 #include "../shader.hpp"
@@ -38,12 +39,15 @@ namespace ee
             }
         }
 
+        // Imports the model with Assimp, unless the binary mesh cache next to it (<model>.meshcache) is up to date.
         void load();
 
     private:
-        void processMesh(const aiMesh* mesh, const aiScene* scene, bool* check = nullptr);
-        void processNode(aiNode* node, const aiScene* scene, bool* check = nullptr);
-        std::vector<Texture> loadTexture(const aiMaterial* mat, aiTextureType type, TextType typeName, bool* check = nullptr);
+        void importMeshes(const std::string& file, std::vector<CachedMesh>* o_meshes);
+        void processMesh(const aiMesh* mesh, const aiScene* scene, std::vector<CachedMesh>* o_meshes, bool* check = nullptr);
+        void processNode(aiNode* node, const aiScene* scene, std::vector<CachedMesh>* o_meshes, bool* check = nullptr);
+        void addTextureNames(const aiMaterial* mat, aiTextureType type, TextType typeName, std::vector<CachedTexture>* o_textures);
+        std::vector<Texture> loadTextures(const std::vector<CachedTexture>& textures, bool* check = nullptr);
 
         // The mesh data
         std::vector<std::vector<Texture>> m_textures;
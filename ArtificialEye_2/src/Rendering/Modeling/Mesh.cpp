@@ -1,9 +1,67 @@
 #include "Mesh.hpp"
+#include "MeshKernels.hpp"
+#include "../../Parallel.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    const std::size_t COMPARE_GRAIN = 4096;
+
+    // beyond this fraction of moved vertices the dirty bookkeeping costs more than it saves (every moved
+    // vertex dirties the faces around it, so the faces are mostly dirty well before the vertices are)
+    const ee::Float INCREMENTAL_MAX_MOVED = 0.15;
+}
+
+std::vector<ee::Vertex>& ee::Mesh::detachVertices()
+{
+    if (m_vertices.use_count() != 1)
+    {
+        std::atomic_store(&m_vertices, std::make_shared<std::vector<Vertex>>(*m_vertices));
+    }
+    return *m_vertices;
+}
+
+std::vector<ee::MeshFace>& ee::Mesh::detachMeshFaces()
+{
+    if (m_faces.use_count() != 1)
+    {
+        std::atomic_store(&m_faces, std::make_shared<std::vector<MeshFace>>(*m_faces));
+    }
+    return *m_faces;
+}
+
+void ee::Mesh::updateVertices(std::vector<Vertex>&& vertices)
+{
+    m_updateCount++;
+    std::atomic_store(&m_vertices, std::make_shared<std::vector<Vertex>>(std::move(vertices)));
+}
+
+void ee::Mesh::updateMeshFaces(std::vector<MeshFace>&& faces)
+{
+    m_updateCount++;
+    m_topologyCount++;
+    std::atomic_store(&m_faces, std::make_shared<std::vector<MeshFace>>(std::move(faces)));
+}
+
+ee::MeshSnapshot ee::Mesh::getSnapshot() const
+{
+    MeshSnapshot snapshot;
+    snapshot.m_mesh = this;
+    snapshot.m_vertices = getVertexBuffer();
+    snapshot.m_faces = getFaceBuffer();
+    snapshot.m_updateCount = m_updateCount;
+    snapshot.m_topologyCount = m_topologyCount;
+    snapshot.m_modelTrans = m_modelTrans;
+    snapshot.m_invModelTrans = m_invModelTrans;
+    snapshot.m_normalModelTrans = m_normalModelTrans;
+    return snapshot;
+}
 
 void ee::Mesh::applyTransformation(Mat4 mat)
 {
     Mat4 normMat = glm::transpose(glm::inverse(mat));
-    for (auto& vec : m_vertices)
+    for (auto& vec : detachVertices())
     {
         vec.m_position = transPoint3(mat, vec.m_position);
         vec.m_normal = transVector3(mat, vec.m_normal);
@@ -12,11 +70,11 @@ void ee::Mesh::applyTransformation(Mat4 mat)
 
 const glm::vec3 ee::Mesh::getNormal(int meshFaceID) const
 {
-    const auto& f = m_faces[meshFaceID];
+    const auto& f = (*m_faces)[meshFaceID];
 
-    Vec3 v0 = m_vertices[f(0)].m_position;
-    Vec3 v1 = m_vertices[f(1)].m_position;
-    Vec3 v2 = m_vertices[f(2)].m_position;
+    Vec3 v0 = (*m_vertices)[f(0)].m_position;
+    Vec3 v1 = (*m_vertices)[f(1)].m_position;
+    Vec3 v2 = (*m_vertices)[f(2)].m_position;
 
     Vec3 e0 = v1 - v0;
     Vec3 e1 = v2 - v0;
@@ -25,42 +83,81 @@ const glm::vec3 ee::Mesh::getNormal(int meshFaceID) const
 
 ee::Float ee::Mesh::calcVolume() const
 {
-    Float total = 0.f;
-    for (const auto& f : m_faces)
+    return std::abs(calcSignedVolume(*m_vertices, *m_faces));
+}
+
+void ee::Mesh::calcNormals()
+{
+    std::vector<Vertex>& vertices = detachVertices();
+    const std::vector<MeshFace>& faces = *m_faces;
+    if (!m_hasNormalCache || m_normalTopologyCount != m_topologyCount || m_vertexFaceStart.size() != vertices.size() + 1 ||
+        m_faceNormals.size() != faces.size())
     {
-        Float stv = glm::dot(m_vertices[f(0)].m_position,
-            glm::cross(m_vertices[f(1)].m_position, m_vertices[f(2)].m_position)) / 6.0;
-        total += stv;
+        buildVertexFaces(faces, vertices.size(), &m_vertexFaceStart, &m_vertexFaces);
+        m_normalTopologyCount = m_topologyCount;
+        m_hasNormalCache = true;
     }
 
-    return std::abs(total);
+    calcFaceNormals(vertices, faces, &m_faceNormals);
+    gatherVertexNormals(m_vertexFaceStart, m_vertexFaces, m_faceNormals, &vertices);
+
+    m_normalPositions.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        m_normalPositions[i] = vertices[i].m_position;
+    }
 }
 
-void ee::Mesh::calcNormals()
+void ee::Mesh::calcNormalsIncremental()
 {
-    m_tempNormals.clear();
-    m_tempNormals.resize(m_vertices.size());
-
-    for (const auto& f : m_faces)
+    const std::vector<MeshFace>& faces = *m_faces;
+    const std::vector<Vertex>& current = *m_vertices;
+    if (!m_hasNormalCache || m_normalTopologyCount != m_topologyCount || m_normalPositions.size() != current.size() ||
+        m_faceNormals.size() != faces.size())
     {
-        const Vec3 v0 = m_vertices[f(0)].m_position;
-        const Vec3 v1 = m_vertices[f(1)].m_position;
-        const Vec3 v2 = m_vertices[f(2)].m_position;
+        calcNormals();
+        return;
+    }
 
-        const Vec3 e0 = v1 - v0;
-        const Vec3 e1 = v2 - v0;
-        const Vec3 tempNormal = flipSameDir(glm::normalize(glm::cross(e0, e1)), glm::normalize(v0 + v1 + v2)); // calculate the temp normal
+    // find the vertices that moved:
+    std::vector<char>& moved = m_movedVertices;
+    moved.assign(current.size(), 0);
+    parallelFor(0, current.size(), [this, &current, &moved](const std::size_t i)
+    {
+        if (current[i].m_position != m_normalPositions[i])
+        {
+            moved[i] = 1;
+            m_normalPositions[i] = current[i].m_position;
+        }
+    }, COMPARE_GRAIN);
 
-        m_tempNormals[f(0)] += tempNormal;
-        m_tempNormals[f(1)] += tempNormal;
-        m_tempNormals[f(2)] += tempNormal;
+    const std::size_t numMoved = std::count(moved.begin(), moved.end(), 1);
+    if (numMoved == 0)
+    {
+        return;
+    }
+    if (numMoved > INCREMENTAL_MAX_MOVED * current.size())
+    {
+        calcNormals();
+        return;
     }
 
-    // normalize those results and update the model itself:
-    for (int i = 0; i < m_tempNormals.size(); i++)
+    // the faces around them and the vertices of those faces:
+    std::vector<char>& dirtyFaces = m_dirtyFaces;
+    std::vector<char>& dirtyVertices = m_dirtyVertices;
+    dirtyFaces.resize(faces.size());
+    dirtyVertices.assign(current.size(), 0);
+    for (std::size_t f = 0; f < faces.size(); f++)
     {
-        Vertex vert = getVertex(i);
-        vert.m_normal = glm::normalize(m_tempNormals[i]);
-        m_vertices[i] = vert;
+        const MeshFace& face = faces[f];
+        dirtyFaces[f] = moved[face(0)] | moved[face(1)] | moved[face(2)];
+        if (dirtyFaces[f])
+        {
+            dirtyVertices[face(0)] = dirtyVertices[face(1)] = dirtyVertices[face(2)] = 1;
+        }
     }
+
+    std::vector<Vertex>& vertices = detachVertices();
+    calcFaceNormals(vertices, faces, &m_faceNormals, &dirtyFaces);
+    gatherVertexNormals(m_vertexFaceStart, m_vertexFaces, m_faceNormals, &vertices, &dirtyVertices);
 }
\ No newline at end of file
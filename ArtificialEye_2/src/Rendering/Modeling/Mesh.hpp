@@ -8,6 +8,7 @@
 #include <string>
 #include <memory>
 #include <array>
+#include <atomic>
 #include <glad/glad.h>
 
 namespace ee
@@ -54,24 +55,88 @@ namespace ee
     // This is a check to make sure that certain meshes are made with the correct types.
     enum class MeshType {INDEXED_RECTANGLE, INDEXED_CUBE, ICOSPHERE, UVSPHERE, UNDEF};
 
+    // Immutable versions of the vertices and faces of a mesh, see Mesh::getVertexBuffer
+    using VertexBuffer = std::shared_ptr<const std::vector<Vertex>>;
+    using FaceBuffer = std::shared_ptr<const std::vector<MeshFace>>;
+
+    // Update count that can be read on any thread, copying it copies the count
+    class UpdateCounter
+    {
+    public:
+        UpdateCounter() : m_count(0) {}
+        UpdateCounter(const UpdateCounter& counter) : m_count(counter.m_count.load()) {}
+        UpdateCounter& operator=(const UpdateCounter& counter) { m_count.store(counter.m_count.load()); return *this; }
+
+        long long unsigned operator++(int) { return m_count++; }
+        operator long long unsigned() const { return m_count.load(); }
+
+    private:
+        std::atomic<long long unsigned> m_count;
+    };
+
+    class Mesh;
+
+    // The buffers, update counts and model transform of a mesh at one point in time (see Mesh::getSnapshot).
+    // Everything that reads the mesh during one task (like tracing the rays of a frame) should read the same
+    // snapshot, the mesh itself can be updated in the meantime.
+    struct MeshSnapshot
+    {
+        const Mesh*         m_mesh;
+        VertexBuffer        m_vertices;
+        FaceBuffer          m_faces;
+        long long unsigned  m_updateCount;
+        long long unsigned  m_topologyCount;
+        Mat4                m_modelTrans;
+        Mat4                m_invModelTrans;
+        Mat4                m_normalModelTrans;
+
+        MeshSnapshot() : m_mesh(nullptr), m_updateCount(0), m_topologyCount(0) {}
+
+        const Vertex& getVertex(int vertexID) const { return (*m_vertices)[vertexID]; }
+        std::size_t getNumVertices() const { return m_vertices ? m_vertices->size() : 0; }
+
+        const MeshFace& getMeshFace(int meshFaceID) const { return (*m_faces)[meshFaceID]; }
+        std::size_t getNumMeshFaces() const { return m_faces ? m_faces->size() : 0; }
+    };
+
+    // The vertices and faces are reference counted buffers that are copied on write. Copying a mesh or
+    // taking a buffer (getVertexBuffer, getFaceBuffer) shares them, and the mesh makes its own copy
+    // before it writes to a buffer that is shared. The update functions swap in a new buffer atomically,
+    // so a buffer that was handed out never changes and can be read on any thread. Writing through the
+    // mesh itself (and handing out buffers) should stay on the thread that owns the mesh.
     class Mesh
     {
     public:
-        Mesh() : m_meshType(MeshType::UNDEF), m_updateCount(0) {}
+        Mesh() : m_meshType(MeshType::UNDEF), m_hasNormalCache(false),
+            m_vertices(std::make_shared<std::vector<Vertex>>()), m_faces(std::make_shared<std::vector<MeshFace>>()) {}
         Mesh(std::vector<Vertex> vertices, std::vector<MeshFace> faces, MeshType type = MeshType::UNDEF) :
-            m_vertices(std::move(vertices)), m_faces(std::move(faces)), m_updateCount(0),
-            m_meshType(type) {}
+            m_vertices(std::make_shared<std::vector<Vertex>>(std::move(vertices))),
+            m_faces(std::make_shared<std::vector<MeshFace>>(std::move(faces))),
+            m_meshType(type), m_hasNormalCache(false) {}
 
         // Transforms the points
         void applyTransformation(Mat4 mat);
 
-        std::vector<Vertex>& getVerticesData() { return m_vertices; }
-        const std::vector<Vertex>& getVerticesData() const { return m_vertices; }
+        // the non const versions copy the buffer first if it is shared
+        std::vector<Vertex>& getVerticesData() { return detachVertices(); }
+        const std::vector<Vertex>& getVerticesData() const { return *m_vertices; }
+
+        std::vector<MeshFace>& getMeshFaceData() { return detachMeshFaces(); }
+        const std::vector<MeshFace>& getMeshFaceData() const { return *m_faces; }
+
+        // Same as getVerticesData, but counts as an update (for writing the vertices in place)
+        std::vector<Vertex>& editVertices() { m_updateCount++; return detachVertices(); }
 
-        std::vector<MeshFace>& getMeshFaceData() { return m_faces; }
-        const std::vector<MeshFace>& getMeshFaceData() const { return m_faces; }
+        // Same as getMeshFaceData, but counts as an update of the faces
+        std::vector<MeshFace>& editMeshFaces() { m_updateCount++; m_topologyCount++; return detachMeshFaces(); }
 
-        virtual const Vertex& getVertex(int vertexID) const { return m_vertices[vertexID]; }
+        VertexBuffer getVertexBuffer() const { return std::atomic_load(&m_vertices); }
+        FaceBuffer getFaceBuffer() const { return std::atomic_load(&m_faces); }
+
+        // the current buffers, counts and transform in one, should be taken on the thread that owns the mesh
+        MeshSnapshot getSnapshot() const;
+
+        virtual const Vertex& getVertex(int vertexID) const { return (*m_vertices)[vertexID]; }
         const Vertex getTransformedVertex(int vertexID)  const
         {
             Vertex result;
@@ -81,13 +146,13 @@ namespace ee
             return result;
         }
 
-        virtual std::size_t getNumVertices() const { return m_vertices.size(); }
+        virtual std::size_t getNumVertices() const { return m_vertices->size(); }
 
-        virtual std::size_t getVertexID(int indexID) const { return reinterpret_cast<const GLuint*>(m_faces.data())[indexID]; }
-        virtual std::size_t getNumIndices() const { return m_faces.size() * 3; }
+        virtual std::size_t getVertexID(int indexID) const { return reinterpret_cast<const GLuint*>(m_faces->data())[indexID]; }
+        virtual std::size_t getNumIndices() const { return m_faces->size() * 3; }
 
-        virtual const MeshFace& getMeshFace(int meshFaceID) const { return m_faces[meshFaceID]; }
-        virtual std::size_t getNumMeshFaces() const { return m_faces.size(); }
+        virtual const MeshFace& getMeshFace(int meshFaceID) const { return (*m_faces)[meshFaceID]; }
+        virtual std::size_t getNumMeshFaces() const { return m_faces->size(); }
 
         virtual const glm::vec3 getNormal(int meshFaceID) const;
 
@@ -95,33 +160,60 @@ namespace ee
         virtual void calcNormals(); // due to winding order not being standardized,
                                     // normals will be calculated based on center position
 
-        void setModelTrans(Mat4 modelTrans) { m_modelTrans = modelTrans; m_normalModelTrans = glm::transpose(glm::inverse(modelTrans)); }
+        // Same as calcNormals, but only the faces around vertices that moved since the last call (of either)
+        // are recalculated. Falls back to calcNormals if the faces were changed or many of the vertices moved.
+        void calcNormalsIncremental();
+
+        void setModelTrans(Mat4 modelTrans)
+        {
+            m_modelTrans = modelTrans;
+            m_invModelTrans = glm::inverse(modelTrans);
+            m_normalModelTrans = glm::transpose(m_invModelTrans);
+        }
         Mat4 getModelTrans() const { return m_modelTrans; }
+        Mat4 getInvModelTrans() const { return m_invModelTrans; } // for moving rays into object space
         Mat4 getNormalModelTrans() const { return m_normalModelTrans; }
 
-        void updateVertex(const Vertex& vertex, std::size_t vertexID) { m_updateCount++; m_vertices[vertexID] = vertex; }
-        void updateVertices(const std::vector<Vertex>& vertices) { m_updateCount++; m_vertices = vertices; }
-        void updateMeshFaces(const std::vector<MeshFace>& faces) { m_updateCount++; m_faces = faces; }
+        void updateVertex(const Vertex& vertex, std::size_t vertexID) { m_updateCount++; detachVertices()[vertexID] = vertex; }
+        void updateVertices(const std::vector<Vertex>& vertices) { updateVertices(std::vector<Vertex>(vertices)); }
+        void updateVertices(std::vector<Vertex>&& vertices);
+        void updateMeshFaces(const std::vector<MeshFace>& faces) { updateMeshFaces(std::vector<MeshFace>(faces)); }
+        void updateMeshFaces(std::vector<MeshFace>&& faces);
 
         long long unsigned getUpdateCount() const { return m_updateCount; }
+        long long unsigned getTopologyCount() const { return m_topologyCount; } // number of times the faces were updated
 
         MeshType getMeshType() const { return m_meshType; }
         void setMeshType(MeshType type) { m_meshType = type; }
 
+    protected:
+        std::vector<Vertex>& detachVertices();
+        std::vector<MeshFace>& detachMeshFaces();
+
     private:
         MeshType m_meshType;
 
         Mat4 m_modelTrans;
+        Mat4 m_invModelTrans;
         Mat4 m_normalModelTrans;
 
         // Number of times the mesh had been updated
-        long long unsigned m_updateCount;
+        UpdateCounter m_updateCount;
+        UpdateCounter m_topologyCount;
 
     protected:
-        // Used with calculating normals
-        std::vector<Vec3> m_tempNormals;
-
-        std::vector<Vertex> m_vertices;
-        std::vector<MeshFace> m_faces;
+        // Used with calculating normals (see MeshKernels)
+        std::vector<std::size_t> m_vertexFaceStart;
+        std::vector<int> m_vertexFaces;
+        std::vector<Vec3> m_faceNormals;
+        std::vector<Vec3> m_normalPositions; // positions the face normals were calculated from
+        std::vector<char> m_movedVertices;   // masks of calcNormalsIncremental, kept between the calls
+        std::vector<char> m_dirtyFaces;
+        std::vector<char> m_dirtyVertices;
+        long long unsigned m_normalTopologyCount;
+        bool m_hasNormalCache;
+
+        std::shared_ptr<std::vector<Vertex>> m_vertices;
+        std::shared_ptr<std::vector<MeshFace>> m_faces;
     };
 }
\ No newline at end of file
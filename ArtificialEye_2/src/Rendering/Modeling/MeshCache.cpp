@@ -0,0 +1,208 @@
+#include "MeshCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    const std::size_t READ_BLOCK_SIZE   = 1 << 16;
+    const uint64_t    MAX_CACHE_COUNT   = 1ULL << 32; // anything larger than this is a corrupt count
+    const uint64_t    MESH_HEADER_SIZE  = 4 * sizeof(uint64_t);
+    const uint64_t    TEXTURE_MIN_SIZE  = 2 * sizeof(uint32_t);
+
+    template<typename T>
+    void writeRaw(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    bool readRaw(std::ifstream& file, T* o_value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(o_value), sizeof(T)));
+    }
+
+    void writePadding(std::ofstream& file, const std::size_t size)
+    {
+        const char zeros[8] = {};
+        file.write(zeros, (8 - size % 8) % 8);
+    }
+
+    // bytes between the read position and the end of the file
+    uint64_t getRemaining(std::ifstream& file, const uint64_t fileSize)
+    {
+        const std::streamoff pos = file.tellg();
+        return pos < 0 || static_cast<uint64_t>(pos) > fileSize ? 0 : fileSize - static_cast<uint64_t>(pos);
+    }
+
+    bool skipPadding(std::ifstream& file, const std::size_t size)
+    {
+        char zeros[8];
+        return static_cast<bool>(file.read(zeros, (8 - size % 8) % 8));
+    }
+
+    void fnv1a(const void* data, const std::size_t size, uint64_t* io_hash)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            *io_hash ^= bytes[i];
+            *io_hash *= 1099511628211ULL;
+        }
+    }
+}
+
+uint64_t ee::calcMeshCacheKey(const std::string& sourceFile, const unsigned importFlags, const unsigned subdivLevel)
+{
+    std::ifstream file(sourceFile, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open " + sourceFile + " for hashing.");
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    std::vector<char> block(READ_BLOCK_SIZE);
+    while (file)
+    {
+        file.read(block.data(), block.size());
+        fnv1a(block.data(), static_cast<std::size_t>(file.gcount()), &hash);
+    }
+
+    const uint32_t extra[4] = { importFlags, subdivLevel, MESH_CACHE_VERSION, static_cast<uint32_t>(sizeof(Vertex)) };
+    fnv1a(extra, sizeof(extra), &hash);
+    return hash;
+}
+
+bool ee::readMeshCache(const std::string& cacheFile, const uint64_t key, std::vector<CachedMesh>* const o_meshes)
+{
+    std::ifstream file(cacheFile, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // the counts are checked against what is left of the file before anything is allocated for them:
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileEnd = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (fileEnd < 0 || !file)
+    {
+        return false;
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(fileEnd);
+
+    char magic[8];
+    uint32_t version, vertexSize;
+    uint64_t fileKey, numMeshes;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MESH_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        !readRaw(file, &version) || version != MESH_CACHE_VERSION ||
+        !readRaw(file, &vertexSize) || vertexSize != sizeof(Vertex) ||
+        !readRaw(file, &fileKey) || fileKey != key ||
+        !readRaw(file, &numMeshes) || numMeshes > MAX_CACHE_COUNT || numMeshes * MESH_HEADER_SIZE > getRemaining(file, fileSize))
+    {
+        return false;
+    }
+
+    std::vector<CachedMesh> meshes(static_cast<std::size_t>(numMeshes));
+    for (CachedMesh& mesh : meshes)
+    {
+        uint64_t numVertices, numFaces, numTextures, flags;
+        if (!readRaw(file, &numVertices) || !readRaw(file, &numFaces) || !readRaw(file, &numTextures) || !readRaw(file, &flags) ||
+            numVertices > MAX_CACHE_COUNT || numFaces > MAX_CACHE_COUNT || numTextures > MAX_CACHE_COUNT ||
+            numVertices * sizeof(Vertex) + numFaces * sizeof(MeshFace) + numTextures * TEXTURE_MIN_SIZE > getRemaining(file, fileSize))
+        {
+            return false;
+        }
+
+        mesh.m_hidden = (flags & MESH_CACHE_HIDDEN) != 0;
+        mesh.m_vertices.resize(static_cast<std::size_t>(numVertices));
+        mesh.m_faces.resize(static_cast<std::size_t>(numFaces));
+        const std::size_t facesSize = mesh.m_faces.size() * sizeof(MeshFace);
+        if (!file.read(reinterpret_cast<char*>(mesh.m_vertices.data()), mesh.m_vertices.size() * sizeof(Vertex)) ||
+            !file.read(reinterpret_cast<char*>(mesh.m_faces.data()), facesSize) || !skipPadding(file, facesSize))
+        {
+            return false;
+        }
+
+        for (const MeshFace& face : mesh.m_faces)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                if (face(k) < 0 || static_cast<uint64_t>(face(k)) >= numVertices)
+                {
+                    return false;
+                }
+            }
+        }
+
+        mesh.m_textures.resize(static_cast<std::size_t>(numTextures));
+        for (CachedTexture& texture : mesh.m_textures)
+        {
+            uint32_t type, length;
+            if (!readRaw(file, &type) || type > static_cast<uint32_t>(TextType::NONE) || !readRaw(file, &length) || length > getRemaining(file, fileSize))
+            {
+                return false;
+            }
+
+            texture.m_type = static_cast<TextType>(type);
+            texture.m_name.resize(length);
+            if (!file.read(&texture.m_name[0], length) || !skipPadding(file, length))
+            {
+                return false;
+            }
+        }
+    }
+
+    *o_meshes = std::move(meshes);
+    return true;
+}
+
+bool ee::writeMeshCache(const std::string& cacheFile, const uint64_t key, const std::vector<CachedMesh>& meshes)
+{
+    // written to a temporary file first, so a crash never leaves half a cache behind:
+    const std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.write(MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+        writeRaw(file, MESH_CACHE_VERSION);
+        writeRaw(file, static_cast<uint32_t>(sizeof(Vertex)));
+        writeRaw(file, key);
+        writeRaw(file, static_cast<uint64_t>(meshes.size()));
+
+        for (const CachedMesh& mesh : meshes)
+        {
+            writeRaw(file, static_cast<uint64_t>(mesh.m_vertices.size()));
+            writeRaw(file, static_cast<uint64_t>(mesh.m_faces.size()));
+            writeRaw(file, static_cast<uint64_t>(mesh.m_textures.size()));
+            writeRaw(file, mesh.m_hidden ? MESH_CACHE_HIDDEN : uint64_t(0));
+
+            const std::size_t facesSize = mesh.m_faces.size() * sizeof(MeshFace);
+            file.write(reinterpret_cast<const char*>(mesh.m_vertices.data()), mesh.m_vertices.size() * sizeof(Vertex));
+            file.write(reinterpret_cast<const char*>(mesh.m_faces.data()), facesSize);
+            writePadding(file, facesSize);
+
+            for (const CachedTexture& texture : mesh.m_textures)
+            {
+                writeRaw(file, static_cast<uint32_t>(texture.m_type));
+                writeRaw(file, static_cast<uint32_t>(texture.m_name.size()));
+                file.write(texture.m_name.data(), texture.m_name.size());
+                writePadding(file, texture.m_name.size());
+            }
+        }
+
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    std::remove(cacheFile.c_str());
+    return std::rename(tempFile.c_str(), cacheFile.c_str()) == 0;
+}
\ No newline at end of file
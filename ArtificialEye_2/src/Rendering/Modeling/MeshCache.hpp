@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "../Textures/Texture.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ee
+{
+    // Layout of a mesh cache file (all values little endian, every array starts on an 8 byte boundary):
+    //
+    //  header:  magic[8] | version u32 | vertexSize u32 | key u64 | numMeshes u64
+    //  meshes:  numVertices u64 | numFaces u64 | numTextures u64 | flags u64 | vertices | faces | padding
+    //           | (type u32 | nameLength u32 | name | padding) * numTextures
+    //
+    // The vertices and faces are stored exactly like in memory (Vertex and MeshFace), so each array is
+    // read with a single call straight into the storage of the mesh. The key identifies the source file
+    // and everything that was done to it (see calcMeshCacheKey), a cache with another key is stale.
+
+    const char     MESH_CACHE_MAGIC[8]  = { 'A', 'E', 'M', 'E', 'S', 'H', '0', '1' };
+    const uint32_t MESH_CACHE_VERSION   = 2;
+    const uint64_t MESH_CACHE_HIDDEN    = 1;
+
+    struct CachedTexture
+    {
+        std::string m_name;     // relative to the directory of the model
+        TextType    m_type;
+    };
+
+    struct CachedMesh
+    {
+        std::vector<Vertex>         m_vertices;
+        std::vector<MeshFace>       m_faces;
+        std::vector<CachedTexture>  m_textures;
+        bool                        m_hidden;       // loaded, but not drawn
+
+        CachedMesh() : m_hidden(false) {}
+    };
+
+    // FNV-1a of the contents of the source file, the import flags, the subdivision level and the cache version.
+    uint64_t calcMeshCacheKey(const std::string& sourceFile, unsigned importFlags, unsigned subdivLevel);
+
+    // Returns false if the cache doesn't exist, is stale or can't be read.
+    bool readMeshCache(const std::string& cacheFile, uint64_t key, std::vector<CachedMesh>* o_meshes);
+
+    // Returns false if the cache couldn't be written.
+    bool writeMeshCache(const std::string& cacheFile, uint64_t key, const std::vector<CachedMesh>& meshes);
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "MeshKernels.hpp"
+#include "../../Parallel.hpp"
+
+#include <glm/gtx/norm.hpp>
+
+namespace
+{
+    const std::size_t FACE_GRAIN    = 2048;
+    const std::size_t VERTEX_GRAIN  = 2048;
+    const std::size_t VOLUME_CHUNKS = 64;   // fixed, so the summation order never changes
+}
+
+void ee::buildVertexFaces(const std::vector<MeshFace>& faces, const std::size_t numVertices, std::vector<std::size_t>* const o_start, std::vector<int>* const o_faces)
+{
+    o_start->assign(numVertices + 1, 0);
+    for (const MeshFace& face : faces)
+    {
+        (*o_start)[face(0) + 1]++;
+        (*o_start)[face(1) + 1]++;
+        (*o_start)[face(2) + 1]++;
+    }
+
+    for (std::size_t i = 0; i < numVertices; i++)
+    {
+        (*o_start)[i + 1] += (*o_start)[i];
+    }
+
+    o_faces->resize(o_start->back());
+    std::vector<std::size_t> fill(o_start->begin(), o_start->end() - 1);
+    for (std::size_t f = 0; f < faces.size(); f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            (*o_faces)[fill[faces[f](k)]++] = static_cast<int>(f);
+        }
+    }
+}
+
+void ee::calcFaceNormals(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces, std::vector<Vec3>* const io_normals,
+    const std::vector<char>* const faceMask)
+{
+    io_normals->resize(faces.size());
+    Vec3* const normals = io_normals->data();
+    parallelFor(0, faces.size(), [&vertices, &faces, normals, faceMask](const std::size_t f)
+    {
+        if (faceMask && !(*faceMask)[f])
+        {
+            return;
+        }
+
+        const MeshFace& face = faces[f];
+        const Vec3& v0 = vertices[face(0)].m_position;
+        const Vec3& v1 = vertices[face(1)].m_position;
+        const Vec3& v2 = vertices[face(2)].m_position;
+        normals[f] = flipSameDir(glm::cross(v1 - v0, v2 - v0), v0 + v1 + v2);
+    }, FACE_GRAIN);
+}
+
+void ee::gatherVertexNormals(const std::vector<std::size_t>& vertexFaceStart, const std::vector<int>& vertexFaces,
+    const std::vector<Vec3>& faceNormals, std::vector<Vertex>* const io_vertices, const std::vector<char>* const vertexMask)
+{
+    Vertex* const vertices = io_vertices->data();
+    parallelFor(0, io_vertices->size(), [&vertexFaceStart, &vertexFaces, &faceNormals, vertices, vertexMask](const std::size_t v)
+    {
+        if (vertexMask && !(*vertexMask)[v])
+        {
+            return;
+        }
+
+        Vec3 sum;
+        for (std::size_t i = vertexFaceStart[v]; i < vertexFaceStart[v + 1]; i++)
+        {
+            sum += faceNormals[vertexFaces[i]];
+        }
+
+        const Float length2 = glm::length2(sum);
+        if (length2 > 0.0)
+        {
+            vertices[v].m_normal = sum / std::sqrt(length2);
+        }
+    }, VERTEX_GRAIN);
+}
+
+ee::Float ee::calcSignedVolume(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces)
+{
+    // the chunks are fixed, the threads only decide who sums which chunk:
+    const std::size_t numChunks = faces.size() < FACE_GRAIN ? 1 : VOLUME_CHUNKS;
+    std::vector<Float> partial(numChunks, 0.0);
+    parallelFor(0, numChunks, [&vertices, &faces, &partial, numChunks](const std::size_t chunk)
+    {
+        const std::size_t begin = faces.size() * chunk / numChunks;
+        const std::size_t end = faces.size() * (chunk + 1) / numChunks;
+
+        Float total = 0.0;
+        for (std::size_t f = begin; f < end; f++)
+        {
+            const MeshFace& face = faces[f];
+            total += glm::dot(vertices[face(0)].m_position, glm::cross(vertices[face(1)].m_position, vertices[face(2)].m_position));
+        }
+        partial[chunk] = total;
+    });
+
+    Float total = 0.0;
+    for (const Float p : partial)
+    {
+        total += p;
+    }
+    return total / 6.0;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Mesh.hpp"
+
+#include <vector>
+
+namespace ee
+{
+    // Builds the faces around every vertex in CSR form: the faces of vertex i are
+    // o_faces[o_start[i]] to o_faces[o_start[i + 1]], in increasing order.
+    void buildVertexFaces(const std::vector<MeshFace>& faces, std::size_t numVertices, std::vector<std::size_t>* o_start, std::vector<int>* o_faces);
+
+    // Area weighted normal of every face (the cross product is not normalized), pointing away from the
+    // center like Mesh::calcNormals. If faceMask is given only the faces with a non zero entry are written.
+    void calcFaceNormals(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces, std::vector<Vec3>* io_normals,
+        const std::vector<char>* faceMask = nullptr);
+
+    // Sums the normals of the faces around every vertex and normalizes them. Every vertex only reads its
+    // own faces, so it runs in parallel without any write conflicts. If vertexMask is given only the vertices
+    // with a non zero entry are written. Vertices without any area around them keep their normal.
+    void gatherVertexNormals(const std::vector<std::size_t>& vertexFaceStart, const std::vector<int>& vertexFaces,
+        const std::vector<Vec3>& faceNormals, std::vector<Vertex>* io_vertices, const std::vector<char>* vertexMask = nullptr);
+
+    // Signed volume of a closed mesh, summed in parallel. The partial sums are always split and added the
+    // same way, so the result doesn't depend on the number of threads.
+    Float calcSignedVolume(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces);
+}
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <glm/gtx/norm.hpp>
+
+namespace
+{
+    // scoring of Forsyth's algorithm:
+    const int       CACHE_SIZE          = 32;
+    const ee::Float CACHE_DECAY_POWER   = 1.5;
+    const ee::Float LAST_FACE_SCORE     = 0.75;
+    const ee::Float VALENCE_BOOST_SCALE = 2.0;
+    const ee::Float VALENCE_BOOST_POWER = 0.5;
+
+    const ee::Float ATTRIBUTE_TOLERANCE = 1.0e-6;
+
+    ee::Float vertexScore(const int cachePosition, const int remainingFaces)
+    {
+        if (remainingFaces == 0)
+        {
+            return -1.0;
+        }
+
+        ee::Float score = 0.0;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // the vertices of the last face get a fixed score, so it isn't favoured to use them right away
+                score = LAST_FACE_SCORE;
+            }
+            else
+            {
+                score = std::pow(1.0 - (cachePosition - 3) / ee::Float(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+            }
+        }
+
+        // favour vertices with few faces left, so they are finished off:
+        return score + VALENCE_BOOST_SCALE * std::pow(ee::Float(remainingFaces), -VALENCE_BOOST_POWER);
+    }
+
+    struct CellHash
+    {
+        std::size_t operator()(const glm::tvec3<long long>& cell) const
+        {
+            return static_cast<std::size_t>(cell.x * 73856093LL ^ cell.y * 19349663LL ^ cell.z * 83492791LL);
+        }
+    };
+
+    bool sameAttributes(const ee::Vertex& a, const ee::Vertex& b)
+    {
+        return glm::all(glm::lessThanEqual(glm::abs(a.m_normal - b.m_normal), ee::Vec3(ATTRIBUTE_TOLERANCE))) &&
+            glm::all(glm::lessThanEqual(glm::abs(a.m_textCoord - b.m_textCoord), ee::Vec2(ATTRIBUTE_TOLERANCE)));
+    }
+}
+
+std::size_t ee::weldVertices(std::vector<Vertex>* const io_vertices, std::vector<MeshFace>* const io_faces, const Float tolerance, const bool positionOnly)
+{
+    std::vector<Vertex>& vertices = *io_vertices;
+    if (vertices.empty())
+    {
+        return 0;
+    }
+
+    Vec3 minPos = vertices[0].m_position;
+    Vec3 maxPos = minPos;
+    for (const Vertex& vertex : vertices)
+    {
+        minPos = glm::min(minPos, vertex.m_position);
+        maxPos = glm::max(maxPos, vertex.m_position);
+    }
+
+    const Float distance = std::max(tolerance * glm::length(maxPos - minPos), std::numeric_limits<Float>::min());
+    const Float distance2 = distance * distance;
+
+    // the cells are as large as the tolerance, so only the neighbouring cells have to be checked:
+    std::unordered_map<glm::tvec3<long long>, std::vector<int>, CellHash> cells;
+    cells.reserve(vertices.size());
+
+    std::vector<int> remap(vertices.size());
+    std::size_t numMerged = 0;
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vec3& position = vertices[i].m_position;
+        const glm::tvec3<long long> cell(glm::floor((position - minPos) / distance));
+
+        int match = -1;
+        for (long long dz = -1; dz <= 1 && match < 0; dz++)
+        {
+            for (long long dy = -1; dy <= 1 && match < 0; dy++)
+            {
+                for (long long dx = -1; dx <= 1 && match < 0; dx++)
+                {
+                    const auto found = cells.find(cell + glm::tvec3<long long>(dx, dy, dz));
+                    if (found == cells.end())
+                    {
+                        continue;
+                    }
+
+                    for (const int other : found->second)
+                    {
+                        if (glm::distance2(vertices[other].m_position, position) <= distance2 &&
+                            (positionOnly || sameAttributes(vertices[other], vertices[i])))
+                        {
+                            match = other;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (match >= 0)
+        {
+            remap[i] = match;
+            numMerged++;
+        }
+        else
+        {
+            remap[i] = static_cast<int>(i);
+            cells[cell].push_back(static_cast<int>(i));
+        }
+    }
+
+    std::vector<MeshFace>& faces = *io_faces;
+    std::size_t numFaces = 0;
+    for (const MeshFace& face : faces)
+    {
+        const MeshFace welded(remap[face(0)], remap[face(1)], remap[face(2)]);
+        if (welded(0) != welded(1) && welded(1) != welded(2) && welded(2) != welded(0))
+        {
+            faces[numFaces++] = welded;
+        }
+    }
+    faces.resize(numFaces);
+
+    // the merged vertices aren't used anymore:
+    optimizeVertexFetch(io_vertices, io_faces);
+    return numMerged;
+}
+
+void ee::optimizeVertexCache(std::vector<MeshFace>* const io_faces, const std::size_t numVertices)
+{
+    const std::vector<MeshFace>& faces = *io_faces;
+    const std::size_t numFaces = faces.size();
+
+    // faces around every vertex (CSR), the faces that were added are moved to the back of each range:
+    std::vector<int> remaining(numVertices, 0);
+    for (const MeshFace& face : faces)
+    {
+        remaining[face(0)]++;
+        remaining[face(1)]++;
+        remaining[face(2)]++;
+    }
+
+    std::vector<std::size_t> start(numVertices + 1, 0);
+    for (std::size_t v = 0; v < numVertices; v++)
+    {
+        start[v + 1] = start[v] + remaining[v];
+    }
+
+    std::vector<int> vertexFaces(start.back());
+    std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+    for (std::size_t f = 0; f < numFaces; f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            vertexFaces[fill[faces[f](k)]++] = static_cast<int>(f);
+        }
+    }
+
+    std::vector<Float> vertexScores(numVertices);
+    for (std::size_t v = 0; v < numVertices; v++)
+    {
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<Float> faceScores(numFaces);
+    for (std::size_t f = 0; f < numFaces; f++)
+    {
+        faceScores[f] = vertexScores[faces[f](0)] + vertexScores[faces[f](1)] + vertexScores[faces[f](2)];
+    }
+
+    std::vector<char> added(numFaces, 0);
+    std::vector<MeshFace> result;
+    result.reserve(numFaces);
+
+    std::vector<int> cache;
+    std::vector<int> nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+
+    std::size_t scanPos = 0;
+    int bestFace = -1;
+    while (result.size() < numFaces)
+    {
+        if (bestFace < 0)
+        {
+            // nothing in the cache can be used, take the next face that is left:
+            while (added[scanPos])
+            {
+                scanPos++;
+            }
+            bestFace = static_cast<int>(scanPos);
+        }
+
+        const MeshFace& face = faces[bestFace];
+        added[bestFace] = 1;
+        result.push_back(face);
+
+        // the vertices of the face go to the front of the cache, the face is moved out of their ranges:
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            const int v = face(k);
+            nextCache.push_back(v);
+
+            const std::size_t end = start[v] + remaining[v];
+            for (std::size_t i = start[v]; i < end; i++)
+            {
+                if (vertexFaces[i] == bestFace)
+                {
+                    std::swap(vertexFaces[i], vertexFaces[end - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        for (const int v : cache)
+        {
+            if (v != face(0) && v != face(1) && v != face(2))
+            {
+                nextCache.push_back(v);
+            }
+        }
+        cache.swap(nextCache);
+
+        // update the scores of everything in the cache, the vertices that fell out keep no position:
+        for (std::size_t i = 0; i < cache.size(); i++)
+        {
+            const int v = cache[i];
+            vertexScores[v] = vertexScore(i < CACHE_SIZE ? static_cast<int>(i) : -1, remaining[v]);
+        }
+
+        bestFace = -1;
+        Float bestScore = -1.0;
+        for (const int v : cache)
+        {
+            for (std::size_t i = start[v]; i < start[v] + remaining[v]; i++)
+            {
+                const int f = vertexFaces[i];
+                faceScores[f] = vertexScores[faces[f](0)] + vertexScores[faces[f](1)] + vertexScores[faces[f](2)];
+                if (faceScores[f] > bestScore)
+                {
+                    bestScore = faceScores[f];
+                    bestFace = f;
+                }
+            }
+        }
+
+        if (cache.size() > CACHE_SIZE)
+        {
+            cache.resize(CACHE_SIZE);
+        }
+    }
+
+    *io_faces = std::move(result);
+}
+
+void ee::optimizeVertexFetch(std::vector<Vertex>* const io_vertices, std::vector<MeshFace>* const io_faces)
+{
+    std::vector<int> remap(io_vertices->size(), -1);
+    std::vector<Vertex> result;
+    result.reserve(io_vertices->size());
+
+    for (MeshFace& face : *io_faces)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int& newID = remap[face(k)];
+            if (newID < 0)
+            {
+                newID = static_cast<int>(result.size());
+                result.push_back((*io_vertices)[face(k)]);
+            }
+            face(k) = newID;
+        }
+    }
+
+    *io_vertices = std::move(result);
+}
+
+ee::Float ee::calcACMR(const std::vector<MeshFace>& faces, const std::size_t numVertices, const std::size_t cacheSize)
+{
+    if (faces.empty())
+    {
+        return 0.0;
+    }
+
+    // FIFO cache, a vertex is in the cache if it was loaded within the last cacheSize misses:
+    std::vector<std::size_t> loadedAt(numVertices, 0);
+    std::size_t numMisses = 0;
+    for (const MeshFace& face : faces)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            std::size_t& loaded = loadedAt[face(k)];
+            if (loaded == 0 || numMisses - loaded >= cacheSize)
+            {
+                numMisses++;
+                loaded = numMisses;
+            }
+        }
+    }
+
+    return Float(numMisses) / faces.size();
+}
\ No newline at end of file
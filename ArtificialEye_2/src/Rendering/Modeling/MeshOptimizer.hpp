@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Mesh.hpp"
+
+#include <vector>
+
+namespace ee
+{
+    // Merges vertices that are closer than tolerance (relative to the diagonal of the bounding box) with a
+    // spatial hash. If positionOnly is false the normals and texture coordinates have to match as well, so
+    // only true duplicates are merged and the seams stay. Welding by position alone connects the seams, which
+    // subdivision and simulation need, the first vertex of every group is kept. Faces that collapse are
+    // removed. Returns the number of vertices that were merged.
+    std::size_t weldVertices(std::vector<Vertex>* io_vertices, std::vector<MeshFace>* io_faces, Float tolerance, bool positionOnly);
+
+    // Reorders the faces for the post transform vertex cache (Forsyth, "Linear-Speed Vertex Cache Optimisation").
+    void optimizeVertexCache(std::vector<MeshFace>* io_faces, std::size_t numVertices);
+
+    // Reorders the vertices in the order the faces first use them and drops unused vertices.
+    void optimizeVertexFetch(std::vector<Vertex>* io_vertices, std::vector<MeshFace>* io_faces);
+
+    // Average number of vertices transformed per face with a FIFO cache of the given size (1.0 is very good,
+    // 3.0 is the worst case).
+    Float calcACMR(const std::vector<MeshFace>& faces, std::size_t numVertices, std::size_t cacheSize);
+}
\ No newline at end of file
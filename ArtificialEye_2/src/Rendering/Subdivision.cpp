@@ -1,216 +1,97 @@
 #include "Subdivision.hpp"
+#include "../Parallel.hpp"
 
-#include <unordered_map>
-#include <array>
-#include <set>
-
-const GLuint GLUINT_MAX = std::numeric_limits<GLuint>::max();
-
-class Edge
-{
-public:
-    int p0() const { return m_p0; }
-    int p1() const { return m_p1; }
-
-    int m_edgePoint;
-    std::array<int, 2> m_faces; // doesn't support holes for now
-
-    void set(GLuint p0, GLuint p1) { sort(); }
-
-    bool operator==(const Edge& e) const { return m_p0 == e.m_p0 && m_p1 == e.m_p1; }
-    bool operator<(const Edge& e) const { return hash() < e.hash(); }
-       
-    std::size_t hash() const
-    {
-        std::size_t p0 = static_cast<std::size_t>(m_p0);
-        std::size_t p1 = static_cast<std::size_t>(m_p1);
-        return p0 | p1 << 32; // simple combination hash
-    }
-
-    Edge() : m_p0(-1), m_p1(-1), m_edgePoint(-1), m_faces({-1, -1 }) {}
-    Edge(GLuint p0, GLuint p1) : m_p0(p0), m_p1(p1), m_edgePoint(-1), m_faces({-1, -1}) { sort(); }
-
-private:
-    void sort()
-    {
-        int p0 = glm::min(m_p0, m_p1);
-        int p1 = glm::max(m_p0, m_p1);
-        m_p0 = p0, m_p1 = p1;
-    }
-
-    int m_p0;
-    int m_p1;
-};
-
-struct EdgePairHash 
-{
-    std::size_t operator() (const Edge& p) const
-    {
-        return p.hash();
-    }
-};
-
-struct EdgePair
+namespace
 {
-    std::vector<int> m_edgePairs;
-    int m_edgePoint = -1;
-};
+    const std::size_t VERTEX_GRAIN = 1024;
 
-bool pointBelongsEdge(int point, Edge edge)
-{
-    return point == edge.p0() || point == edge.p1();
-}
-
-void lsdAddToEdgeList(int p0, int p1, int op, std::unordered_map<Edge, EdgePair, EdgePairHash>& edgeList)
-{
-    Edge edge(p0, p1);
-    auto it = edgeList.find(edge);
-    if (it == edgeList.end()) // if it doesn't exist, insert it
+    void subdivideVertices(const ee::SubdivisionTopology& topology, const std::vector<ee::Vertex>& vertices,
+        const std::vector<ee::MeshFace>& faces, std::vector<ee::Vertex>* const o_vertices)
     {
-        EdgePair pair;
-        pair.m_edgePairs.push_back(op);
-        auto insPair = std::make_pair(edge, pair);
-        edgeList.insert(insPair);
-    }
-    else
-    {
-        it->second.m_edgePairs.push_back(op); // if it does, good
-    }
-}
+        o_vertices->resize(topology.getNumRefinedVertices());
+        ee::Vertex* const out = o_vertices->data();
 
-int lsdCalcEdgeList(Edge edge, std::unordered_map<Edge, EdgePair, EdgePairHash>& edgeList, const std::vector<ee::Vertex>& oldVerts, std::vector<ee::Vertex>& vertices)
-{
-    auto it = edgeList.find(edge); assert(it != edgeList.end());
-    if (it->second.m_edgePoint >= 0)
-    {
-        return it->second.m_edgePoint;
-    }
+        // vertex points, (1 - n * beta) * old + beta * sum(neighbours):
+        ee::parallelFor(0, topology.getNumVertices(), [&topology, &vertices, out](const std::size_t v)
+        {
+            const std::size_t n = topology.getValence(v);
+            ee::Vertex result;
+            result.m_textCoord = vertices[v].m_textCoord;
+            if (n == 0)
+            {
+                result.m_position = vertices[v].m_position;
+            }
+            else
+            {
+                ee::Vec3 sumPoint;
+                for (const int* it = topology.getRingBegin(v); it != topology.getRingEnd(v); ++it)
+                {
+                    sumPoint += vertices[*it].m_position;
+                }
 
-    const std::vector<int>& pairs = it->second.m_edgePairs;
-    ee::Vec3 edgePoint;
-    if (pairs.size() == 2)
-    {
-        edgePoint = 3.0 / 8.0 * (oldVerts[edge.p0()].m_position + oldVerts[edge.p1()].m_position) +
-            1.0 / 8.0 * (oldVerts[pairs[0]].m_position + oldVerts[pairs[1]].m_position);
-    }
-    else
-    {
-        // if there is a boundary case
-        edgePoint = 0.5 * (oldVerts[edge.p0()].m_position + oldVerts[edge.p1()].m_position);
-    }
+                const ee::Float beta = ee::SubdivisionTopology::betaConst(n);
+                result.m_position = (1.0 - beta * n) * vertices[v].m_position + beta * sumPoint;
+            }
+            out[v] = result;
+        }, VERTEX_GRAIN);
 
-    vertices.push_back(ee::Vertex(edgePoint));
-    it->second.m_edgePoint = vertices.size() - 1;
-    return it->second.m_edgePoint;
-}
+        // edge points, 3/8 of the edge and 1/8 of the opposite vertices, the middle on boundaries:
+        ee::parallelFor(0, topology.getNumEdges(), [&topology, &vertices, &faces, out](const std::size_t e)
+        {
+            const ee::Vertex& v0 = vertices[topology.getEdgeVertex(e, 0)];
+            const ee::Vertex& v1 = vertices[topology.getEdgeVertex(e, 1)];
 
-float lsdBetaConst(int n)
-{
-    if (n <= 3)
-    {
-        return 3.0 / 16.0;
+            ee::Vertex result;
+            result.m_textCoord = 0.5 * (v0.m_textCoord + v1.m_textCoord);
+            if (topology.isInteriorEdge(e))
+            {
+                result.m_position = 3.0 / 8.0 * (v0.m_position + v1.m_position) +
+                    1.0 / 8.0 * (vertices[topology.getOppositeVertex(faces, e, 0)].m_position + vertices[topology.getOppositeVertex(faces, e, 1)].m_position);
+            }
+            else
+            {
+                result.m_position = 0.5 * (v0.m_position + v1.m_position);
+            }
+            out[topology.getEdgePoint(e)] = result;
+        }, VERTEX_GRAIN);
     }
-
-    const ee::Float inner = 3.0 / 8.0 + 1.0 / 4.0 * std::cos(ee::PI2 / n);
-    return (1.0 / n) * (5.0 / 8.0 - inner * inner);
 }
 
 ee::Mesh ee::loopSubdiv(const Mesh& mesh, int recursion)
 {
     if (recursion <= 0) { return mesh; }
 
-    std::unordered_map<Edge, EdgePair, EdgePairHash> edgeList; // stores edges and corresponding "pairs"
-    std::vector<std::set<int>> vertexList; // stores neighboring points of points
-
-    const std::vector<Vertex>& oVertices = mesh.getVerticesData();
-    const std::vector<MeshFace>& oFaces = mesh.getMeshFaceData();
-
-    vertexList.resize(oVertices.size());
+    LoopSubdivWorkspace workspace;
+    std::vector<Vertex> vertices;
+    std::vector<MeshFace> faces;
+    loopSubdiv(mesh.getVerticesData(), mesh.getMeshFaceData(), recursion, &vertices, &faces, &workspace);
+    return Mesh(std::move(vertices), std::move(faces));
+}
 
-    // set up both lists:
-    for (int faceID = 0; faceID < oFaces.size(); faceID++)
+void ee::loopSubdiv(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces, const int recursion,
+    std::vector<Vertex>* const o_vertices, std::vector<MeshFace>* const o_faces, LoopSubdivWorkspace* const workspace)
+{
+    if (recursion <= 0)
     {
-        // prepare the edge faces:
-        MeshFace f = oFaces[faceID];
-        lsdAddToEdgeList(f(0), f(1), f(2), edgeList);
-        lsdAddToEdgeList(f(1), f(2), f(0), edgeList);
-        lsdAddToEdgeList(f(2), f(0), f(1), edgeList);
-
-        // prepare the vertexList:
-        vertexList[f(0)].insert(f(1)); vertexList[f(0)].insert(f(2));
-        vertexList[f(1)].insert(f(0)); vertexList[f(1)].insert(f(2));
-        vertexList[f(2)].insert(f(1)); vertexList[f(2)].insert(f(0));
+        *o_vertices = vertices;
+        *o_faces = faces;
+        return;
     }
 
-    // now we calculate the new points and the new faces
-    std::vector<Vertex> tempVerts;
-    tempVerts.resize(oVertices.size());
-    std::vector<MeshFace> tempFaces;
-
-    for (MeshFace f : oFaces)
+    // ping-pong between the workspace buffers, the last level is written to the output:
+    const std::vector<Vertex>* srcVertices = &vertices;
+    const std::vector<MeshFace>* srcFaces = &faces;
+    for (int level = 0; level < recursion; level++)
     {
-        // some syntactical sugar:
-        Edge edges[3] =
-        {
-            Edge(f(0), f(1)),
-            Edge(f(1), f(2)),
-            Edge(f(2), f(0))
-        };
-
-        // calculate the edge points for this face:
-        int edgePoints[3];
-        for (int i = 0; i < 3; i++) { edgePoints[i] = lsdCalcEdgeList(edges[i], edgeList, oVertices, tempVerts); }
-
-        MeshFace middleFace;
-        middleFace(0) = edgePoints[0];
-        Vec3 p0 = tempVerts[edgePoints[0]].m_position;
-        middleFace(1) = edgePoints[1];
-        Vec3 p1 = tempVerts[edgePoints[0]].m_position;
-        middleFace(2) = edgePoints[2];
-        Vec3 p2 = tempVerts[edgePoints[0]].m_position;
-        tempFaces.push_back(middleFace); // we can do the middle one right now
-
-        // for each vertex of the point:
-        for (int i = 0; i < 3; i++)
-        {
-            int vertID = f(i);
-
-            // calculate the new vertex:
-            if (!vertexList[vertID].empty())
-            {
-                Vec3 sumPoint, oldPoint = oVertices[vertID].m_position;
-                for (int p : vertexList[vertID])
-                {
-                    sumPoint += oVertices[p].m_position;
-                }
-
-                int n = vertexList[vertID].size();
-                const Float beta = lsdBetaConst(n);
-
-                Vec3 newPoint = (1 - beta * n) * oldPoint + beta * sumPoint;
-                tempVerts[vertID] = newPoint;
-                vertexList[vertID].clear(); // indicate that we are done
-            }
-
-            std::vector<int> belongingEdgePoints;
+        const bool last = level + 1 == recursion;
+        std::vector<Vertex>* const dstVertices = last ? o_vertices : &workspace->m_vertices[level % 2];
+        std::vector<MeshFace>* const dstFaces = last ? o_faces : &workspace->m_faces[level % 2];
 
-            // select the appropriate edge points:
-            for (int j = 0; j < 3; j++)
-            {
-                if (pointBelongsEdge(vertID, edges[j]))
-                {
-                    belongingEdgePoints.push_back(edgePoints[j]);
-                }
-            }
-            assert(belongingEdgePoints.size() == 2);
+        workspace->m_topology.build(srcVertices->size(), *srcFaces);
+        subdivideVertices(workspace->m_topology, *srcVertices, *srcFaces, dstVertices);
+        workspace->m_topology.buildRefinedFaces(*srcFaces, dstFaces);
 
-            // push another triangle
-            MeshFace currNewFace;
-            currNewFace(0) = belongingEdgePoints[0];
-            currNewFace(1) = belongingEdgePoints[1];
-            currNewFace(2) = vertID;
-            tempFaces.push_back(currNewFace);
-        }
+        srcVertices = dstVertices;
+        srcFaces = dstFaces;
     }
-    return loopSubdiv(Mesh(tempVerts, tempFaces), recursion - 1);
 }
\ No newline at end of file
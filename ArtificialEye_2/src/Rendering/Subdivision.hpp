@@ -1,8 +1,24 @@
 #pragma once
 
 #include "Modeling/Mesh.hpp"
+#include "SubdivisionTopology.hpp"
+
+#include <vector>
 
 namespace ee
 {
+    // Scratch storage of loopSubdiv, reusing it between calls avoids the allocations once it has grown.
+    struct LoopSubdivWorkspace
+    {
+        SubdivisionTopology     m_topology;
+        std::vector<Vertex>     m_vertices[2];
+        std::vector<MeshFace>   m_faces[2];
+    };
+
     Mesh loopSubdiv(const Mesh& mesh, int recursion);
+
+    // The outputs must not be the inputs. Old vertices keep their texture coordinates and edge points get
+    // the middle of their edge, the normals are left to be calculated.
+    void loopSubdiv(const std::vector<Vertex>& vertices, const std::vector<MeshFace>& faces, int recursion,
+        std::vector<Vertex>* o_vertices, std::vector<MeshFace>* o_faces, LoopSubdivWorkspace* workspace);
 }
\ No newline at end of file
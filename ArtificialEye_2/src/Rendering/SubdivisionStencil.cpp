@@ -0,0 +1,266 @@
+#include "SubdivisionStencil.hpp"
+#include "SubdivisionTopology.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <stdexcept>
+
+namespace
+{
+    const std::size_t APPLY_GRAIN = 512;
+
+    struct SparseMatrix
+    {
+        std::vector<std::size_t>    m_rowStart;
+        std::vector<int>            m_columns;
+        std::vector<ee::Float>      m_weights;
+
+        std::size_t getNumRows() const { return m_rowStart.size() - 1; }
+    };
+
+    // One level of loop subdivision, numbered like loopSubdiv.
+    void buildLevel(ee::SubdivisionTopology* const topology, const std::size_t numVertices, const std::vector<ee::MeshFace>& faces,
+        SparseMatrix* const o_matrix, std::vector<ee::MeshFace>* const o_faces)
+    {
+        topology->build(numVertices, faces);
+
+        // row sizes, then the rows themselves:
+        const std::size_t numRows = topology->getNumRefinedVertices();
+        o_matrix->m_rowStart.assign(numRows + 1, 0);
+        for (std::size_t v = 0; v < numVertices; v++)
+        {
+            o_matrix->m_rowStart[v + 1] = 1 + topology->getValence(v);
+        }
+        for (std::size_t e = 0; e < topology->getNumEdges(); e++)
+        {
+            o_matrix->m_rowStart[topology->getEdgePoint(e) + 1] = topology->isInteriorEdge(e) ? 4 : 2;
+        }
+        for (std::size_t r = 0; r < numRows; r++)
+        {
+            o_matrix->m_rowStart[r + 1] += o_matrix->m_rowStart[r];
+        }
+
+        o_matrix->m_columns.resize(o_matrix->m_rowStart.back());
+        o_matrix->m_weights.resize(o_matrix->m_rowStart.back());
+
+        // vertex points, (1 - n * beta) * old + beta * sum(neighbours), unused vertices are kept as they are:
+        for (std::size_t v = 0; v < numVertices; v++)
+        {
+            const std::size_t n = topology->getValence(v);
+            const ee::Float beta = n > 0 ? ee::SubdivisionTopology::betaConst(n) : 0.0;
+
+            std::size_t pos = o_matrix->m_rowStart[v];
+            o_matrix->m_columns[pos] = static_cast<int>(v);
+            o_matrix->m_weights[pos++] = 1.0 - beta * n;
+            for (const int* it = topology->getRingBegin(v); it != topology->getRingEnd(v); ++it)
+            {
+                o_matrix->m_columns[pos] = *it;
+                o_matrix->m_weights[pos++] = beta;
+            }
+        }
+
+        // edge points, 3/8 of the edge and 1/8 of the opposite vertices, the middle on boundaries:
+        for (std::size_t e = 0; e < topology->getNumEdges(); e++)
+        {
+            const bool interior = topology->isInteriorEdge(e);
+            std::size_t pos = o_matrix->m_rowStart[topology->getEdgePoint(e)];
+
+            o_matrix->m_columns[pos] = topology->getEdgeVertex(e, 0);
+            o_matrix->m_weights[pos++] = interior ? 3.0 / 8.0 : 0.5;
+            o_matrix->m_columns[pos] = topology->getEdgeVertex(e, 1);
+            o_matrix->m_weights[pos++] = interior ? 3.0 / 8.0 : 0.5;
+            if (interior)
+            {
+                for (std::size_t i = 0; i < 2; i++)
+                {
+                    o_matrix->m_columns[pos] = topology->getOppositeVertex(faces, e, i);
+                    o_matrix->m_weights[pos++] = 1.0 / 8.0;
+                }
+            }
+        }
+
+        topology->buildRefinedFaces(faces, o_faces);
+    }
+
+    // o_result = a * b, with the columns of every row sorted
+    void multiply(const SparseMatrix& a, const SparseMatrix& b, const std::size_t numColumns, SparseMatrix* const o_result)
+    {
+        std::vector<ee::Float> accum(numColumns, 0.0);
+        std::vector<int> marker(numColumns, -1);
+        std::vector<int> rowColumns;
+
+        o_result->m_rowStart.assign(1, 0);
+        o_result->m_columns.clear();
+        o_result->m_weights.clear();
+        for (std::size_t r = 0; r < a.getNumRows(); r++)
+        {
+            rowColumns.clear();
+            for (std::size_t i = a.m_rowStart[r]; i < a.m_rowStart[r + 1]; i++)
+            {
+                const int k = a.m_columns[i];
+                for (std::size_t j = b.m_rowStart[k]; j < b.m_rowStart[k + 1]; j++)
+                {
+                    const int c = b.m_columns[j];
+                    if (marker[c] != static_cast<int>(r))
+                    {
+                        marker[c] = static_cast<int>(r);
+                        accum[c] = 0.0;
+                        rowColumns.push_back(c);
+                    }
+                    accum[c] += a.m_weights[i] * b.m_weights[j];
+                }
+            }
+
+            std::sort(rowColumns.begin(), rowColumns.end());
+            for (int c : rowColumns)
+            {
+                o_result->m_columns.push_back(c);
+                o_result->m_weights.push_back(accum[c]);
+            }
+            o_result->m_rowStart.push_back(o_result->m_columns.size());
+        }
+    }
+
+    uint64_t hashTopology(const ee::Mesh& mesh, const int recursion)
+    {
+        // FNV-1a over the indices:
+        uint64_t hash = 14695981039346656037ULL;
+        auto combine = [&hash](const uint64_t value)
+        {
+            hash ^= value;
+            hash *= 1099511628211ULL;
+        };
+
+        combine(mesh.getVerticesData().size());
+        combine(static_cast<uint64_t>(recursion));
+        for (const ee::MeshFace& face : mesh.getMeshFaceData())
+        {
+            combine(static_cast<uint64_t>(face(0)));
+            combine(static_cast<uint64_t>(face(1)));
+            combine(static_cast<uint64_t>(face(2)));
+        }
+        return hash;
+    }
+
+    bool sameFaces(const std::vector<ee::MeshFace>& a, const std::vector<ee::MeshFace>& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const ee::MeshFace& fa, const ee::MeshFace& fb)
+        {
+            return fa(0) == fb(0) && fa(1) == fb(1) && fa(2) == fb(2);
+        });
+    }
+
+    std::mutex g_stencilCacheMutex;
+    std::unordered_multimap<uint64_t, std::unique_ptr<ee::SubdivisionStencil>> g_stencilCache;
+}
+
+ee::SubdivisionStencil::SubdivisionStencil(const Mesh& mesh, const int recursion) :
+    m_coarseFaces(mesh.getMeshFaceData()),
+    m_numCoarseVertices(mesh.getVerticesData().size()),
+    m_recursion(recursion)
+{
+    // start with the identity:
+    SparseMatrix total;
+    total.m_rowStart.resize(m_numCoarseVertices + 1);
+    total.m_columns.resize(m_numCoarseVertices);
+    total.m_weights.assign(m_numCoarseVertices, 1.0);
+    for (std::size_t i = 0; i < m_numCoarseVertices; i++)
+    {
+        total.m_rowStart[i] = i;
+        total.m_columns[i] = static_cast<int>(i);
+    }
+    total.m_rowStart[m_numCoarseVertices] = m_numCoarseVertices;
+    m_faces = m_coarseFaces;
+
+    SubdivisionTopology topology;
+    std::size_t numVertices = m_numCoarseVertices;
+    for (int level = 0; level < recursion; level++)
+    {
+        SparseMatrix levelMatrix, product;
+        std::vector<MeshFace> levelFaces;
+        buildLevel(&topology, numVertices, m_faces, &levelMatrix, &levelFaces);
+        multiply(levelMatrix, total, m_numCoarseVertices, &product);
+
+        total = std::move(product);
+        m_faces = std::move(levelFaces);
+        numVertices = total.getNumRows();
+    }
+
+    m_rowStart = std::move(total.m_rowStart);
+    m_columns = std::move(total.m_columns);
+    m_weights = std::move(total.m_weights);
+}
+
+void ee::SubdivisionStencil::apply(const std::vector<Vertex>& coarse, std::vector<Vertex>* const o_refined) const
+{
+    if (coarse.size() != m_numCoarseVertices)
+    {
+        throw std::logic_error("The subdivision stencil was built for a different number of vertices.");
+    }
+
+    o_refined->resize(getNumRefinedVertices());
+    Vertex* const out = o_refined->data();
+    parallelFor(0, getNumRefinedVertices(), [this, &coarse, out](const std::size_t row)
+    {
+        Vec3 position;
+        for (std::size_t i = m_rowStart[row]; i < m_rowStart[row + 1]; i++)
+        {
+            position += m_weights[i] * coarse[m_columns[i]].m_position;
+        }
+        out[row].m_position = position;
+    }, APPLY_GRAIN);
+}
+
+const std::vector<ee::MeshFace>& ee::SubdivisionStencil::getMeshFaces() const
+{
+    return m_faces;
+}
+
+const std::vector<ee::MeshFace>& ee::SubdivisionStencil::getCoarseMeshFaces() const
+{
+    return m_coarseFaces;
+}
+
+std::size_t ee::SubdivisionStencil::getNumCoarseVertices() const
+{
+    return m_numCoarseVertices;
+}
+
+std::size_t ee::SubdivisionStencil::getNumRefinedVertices() const
+{
+    return m_rowStart.size() - 1;
+}
+
+std::size_t ee::SubdivisionStencil::getNumNonZeros() const
+{
+    return m_columns.size();
+}
+
+int ee::SubdivisionStencil::getRecursion() const
+{
+    return m_recursion;
+}
+
+const ee::SubdivisionStencil& ee::getSubdivisionStencil(const Mesh& mesh, const int recursion)
+{
+    const uint64_t hash = hashTopology(mesh, recursion);
+
+    std::lock_guard<std::mutex> lock(g_stencilCacheMutex);
+    auto range = g_stencilCache.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const SubdivisionStencil& stencil = *it->second;
+        if (stencil.getRecursion() == recursion && stencil.getNumCoarseVertices() == mesh.getVerticesData().size() &&
+            sameFaces(stencil.getCoarseMeshFaces(), mesh.getMeshFaceData()))
+        {
+            return stencil;
+        }
+    }
+
+    auto it = g_stencilCache.insert(std::make_pair(hash, std::unique_ptr<SubdivisionStencil>(new SubdivisionStencil(mesh, recursion))));
+    return *it->second;
+}
\ No newline at end of file
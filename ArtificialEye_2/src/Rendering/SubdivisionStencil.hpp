@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Modeling/Mesh.hpp"
+
+#include <vector>
+
+namespace ee
+{
+    // The loop subdivision of a mesh is linear in the vertex positions, so for a fixed topology it is a
+    // sparse matrix that maps the coarse positions to the refined ones. The matrix (all the levels
+    // multiplied together) and the refined faces are built once, every frame after that is a single
+    // sparse matrix vector product. The refined vertices and faces are in the same order as loopSubdiv.
+    class SubdivisionStencil
+    {
+    public:
+        SubdivisionStencil(const Mesh& mesh, int recursion);
+
+        // Only the positions are written (like loopSubdiv), o_refined is resized if needed.
+        void apply(const std::vector<Vertex>& coarse, std::vector<Vertex>* o_refined) const;
+
+        const std::vector<MeshFace>& getMeshFaces() const;
+        const std::vector<MeshFace>& getCoarseMeshFaces() const;
+        std::size_t getNumCoarseVertices() const;
+        std::size_t getNumRefinedVertices() const;
+        std::size_t getNumNonZeros() const;
+        int getRecursion() const;
+
+    private:
+        // CSR matrix, row i holds the weights of refined vertex i:
+        std::vector<std::size_t>    m_rowStart;
+        std::vector<int>            m_columns;
+        std::vector<Float>          m_weights;
+
+        std::vector<MeshFace>       m_faces;
+        std::vector<MeshFace>       m_coarseFaces;
+        std::size_t                 m_numCoarseVertices;
+        int                         m_recursion;
+    };
+
+    // Returns the stencil for the topology of the mesh (its faces and number of vertices), the stencil is
+    // only built the first time a topology and recursion are seen. The reference stays valid.
+    const SubdivisionStencil& getSubdivisionStencil(const Mesh& mesh, int recursion);
+}
\ No newline at end of file
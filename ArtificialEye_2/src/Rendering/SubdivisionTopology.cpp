@@ -0,0 +1,108 @@
+#include "SubdivisionTopology.hpp"
+#include "../Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const std::size_t FACE_GRAIN = 1024;
+}
+
+void ee::SubdivisionTopology::build(const std::size_t numVertices, const std::vector<MeshFace>& faces)
+{
+    // sort-based edge extraction, every edge of every face is a slot:
+    m_slots.resize(3 * faces.size());
+    for (std::size_t f = 0; f < faces.size(); f++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            const int a = faces[f](k);
+            const int b = faces[f]((k + 1) % 3);
+            EdgeSlot& slot = m_slots[3 * f + k];
+            slot.m_p0 = std::min(a, b);
+            slot.m_p1 = std::max(a, b);
+            slot.m_slot = static_cast<uint32_t>(3 * f + k);
+        }
+    }
+    std::sort(m_slots.begin(), m_slots.end());
+
+    m_edgeStart.clear();
+    m_slotEdges.resize(m_slots.size());
+    for (std::size_t i = 0; i < m_slots.size(); i++)
+    {
+        if (i == 0 || m_slots[i].m_p0 != m_slots[i - 1].m_p0 || m_slots[i].m_p1 != m_slots[i - 1].m_p1)
+        {
+            m_edgeStart.push_back(i);
+        }
+        m_slotEdges[m_slots[i].m_slot] = static_cast<int>(m_edgeStart.size()) - 1;
+    }
+    const std::size_t numEdges = m_edgeStart.size();
+    m_edgeStart.push_back(m_slots.size());
+
+    // edge point IDs in order of the first face that uses the edge:
+    m_edgePoints.assign(numEdges, -1);
+    int nextPoint = static_cast<int>(numVertices);
+    for (int edgeID : m_slotEdges)
+    {
+        if (m_edgePoints[edgeID] < 0)
+        {
+            m_edgePoints[edgeID] = nextPoint++;
+        }
+    }
+
+    // vertex rings, the edges are unique so the neighbours are as well:
+    m_valenceStart.assign(numVertices + 1, 0);
+    for (std::size_t e = 0; e < numEdges; e++)
+    {
+        m_valenceStart[getEdgeVertex(e, 0) + 1]++;
+        m_valenceStart[getEdgeVertex(e, 1) + 1]++;
+    }
+    for (std::size_t v = 0; v < numVertices; v++)
+    {
+        m_valenceStart[v + 1] += m_valenceStart[v];
+    }
+
+    m_ring.resize(m_valenceStart.back());
+    m_ringFill.assign(m_valenceStart.begin(), m_valenceStart.end() - 1);
+    for (std::size_t e = 0; e < numEdges; e++)
+    {
+        const int a = getEdgeVertex(e, 0);
+        const int b = getEdgeVertex(e, 1);
+        m_ring[m_ringFill[a]++] = b;
+        m_ring[m_ringFill[b]++] = a;
+    }
+}
+
+int ee::SubdivisionTopology::getOppositeVertex(const std::vector<MeshFace>& faces, const std::size_t edgeID, const std::size_t i) const
+{
+    const uint32_t slot = m_slots[m_edgeStart[edgeID] + i].m_slot;
+    return faces[slot / 3]((slot % 3 + 2) % 3);
+}
+
+void ee::SubdivisionTopology::buildRefinedFaces(const std::vector<MeshFace>& faces, std::vector<MeshFace>* const o_faces) const
+{
+    o_faces->resize(4 * faces.size());
+    MeshFace* const out = o_faces->data();
+    parallelFor(0, faces.size(), [this, &faces, out](const std::size_t f)
+    {
+        const int e0 = m_edgePoints[m_slotEdges[3 * f]];
+        const int e1 = m_edgePoints[m_slotEdges[3 * f + 1]];
+        const int e2 = m_edgePoints[m_slotEdges[3 * f + 2]];
+        out[4 * f] = MeshFace(e0, e1, e2);
+        out[4 * f + 1] = MeshFace(e0, e2, faces[f](0));
+        out[4 * f + 2] = MeshFace(e0, e1, faces[f](1));
+        out[4 * f + 3] = MeshFace(e1, e2, faces[f](2));
+    }, FACE_GRAIN);
+}
+
+ee::Float ee::SubdivisionTopology::betaConst(const std::size_t valence)
+{
+    if (valence <= 3)
+    {
+        return 3.0 / 16.0;
+    }
+
+    const Float inner = 3.0 / 8.0 + 1.0 / 4.0 * std::cos(PI2 / valence);
+    return (1.0 / valence) * (5.0 / 8.0 - inner * inner);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Modeling/Mesh.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace ee
+{
+    // Connectivity needed by one level of loop subdivision, kept in flat arrays so that rebuilding it
+    // doesn't allocate once the storage has grown. Edges are found by sorting the edges of all faces,
+    // the vertex rings are in CSR form. The IDs of the refined mesh follow loopSubdiv: old vertices keep
+    // their IDs and the edge points follow in the order the edges are first used by the faces.
+    class SubdivisionTopology
+    {
+    public:
+        void build(std::size_t numVertices, const std::vector<MeshFace>& faces);
+
+        std::size_t getNumVertices() const { return m_valenceStart.size() - 1; }
+        std::size_t getNumEdges() const { return m_edgeStart.size() - 1; }
+        std::size_t getNumRefinedVertices() const { return getNumVertices() + getNumEdges(); }
+
+        int getEdgeVertex(std::size_t edgeID, int end) const { return end == 0 ? m_slots[m_edgeStart[edgeID]].m_p0 : m_slots[m_edgeStart[edgeID]].m_p1; }
+        int getEdgePoint(std::size_t edgeID) const { return m_edgePoints[edgeID]; }
+        bool isInteriorEdge(std::size_t edgeID) const { return m_edgeStart[edgeID + 1] - m_edgeStart[edgeID] == 2; }
+
+        // the vertices opposite of the edge in the faces that share it:
+        std::size_t getNumEdgeFaces(std::size_t edgeID) const { return m_edgeStart[edgeID + 1] - m_edgeStart[edgeID]; }
+        int getOppositeVertex(const std::vector<MeshFace>& faces, std::size_t edgeID, std::size_t i) const;
+        std::size_t getEdgeFace(std::size_t edgeID, std::size_t i) const { return m_slots[m_edgeStart[edgeID] + i].m_slot / 3; }
+
+        // edge k of a face goes from vertex k to vertex (k + 1) % 3:
+        int getFaceEdge(std::size_t faceID, int k) const { return m_slotEdges[3 * faceID + k]; }
+
+        // unique neighbours of a vertex:
+        std::size_t getValence(std::size_t vertexID) const { return m_valenceStart[vertexID + 1] - m_valenceStart[vertexID]; }
+        const int* getRingBegin(std::size_t vertexID) const { return m_ring.data() + m_valenceStart[vertexID]; }
+        const int* getRingEnd(std::size_t vertexID) const { return m_ring.data() + m_valenceStart[vertexID + 1]; }
+
+        // Four faces per face: the middle one, then one per corner. o_faces is resized.
+        void buildRefinedFaces(const std::vector<MeshFace>& faces, std::vector<MeshFace>* o_faces) const;
+
+        static Float betaConst(std::size_t valence);
+
+    private:
+        struct EdgeSlot
+        {
+            int         m_p0;
+            int         m_p1;
+            uint32_t    m_slot; // 3 * face + edge of the face
+
+            bool operator<(const EdgeSlot& e) const
+            {
+                return m_p0 != e.m_p0 ? m_p0 < e.m_p0 : (m_p1 != e.m_p1 ? m_p1 < e.m_p1 : m_slot < e.m_slot);
+            }
+        };
+
+        std::vector<EdgeSlot>       m_slots;        // sorted by edge
+        std::vector<std::size_t>    m_edgeStart;    // slots of edge e are [m_edgeStart[e], m_edgeStart[e + 1])
+        std::vector<int>            m_slotEdges;    // edge of every face slot
+        std::vector<int>            m_edgePoints;   // refined vertex ID of every edge
+
+        std::vector<std::size_t>    m_valenceStart;
+        std::vector<int>            m_ring;
+        std::vector<std::size_t>    m_ringFill;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "SBShapeMatchConstraint.hpp"
+
+#include <stdexcept>
+#include <glm/gtx/norm.hpp>
+
+namespace
+{
+    const int   MAX_ROTATION_ITERATIONS = 4;
+    const ee::Float ROTATION_EPS        = 1.0e-9;
+}
+
+ee::SBShapeMatchConstraint::SBShapeMatchConstraint(std::vector<SBObject*> objects, const Float stiffness) :
+    m_stiffness(stiffness),
+    m_objects(std::move(objects)),
+    m_rotation(1.0, 0.0, 0.0, 0.0)
+{
+    if (m_objects.empty())
+    {
+        throw std::logic_error("A shape matching region needs at least one object.");
+    }
+
+    Float totalMass = 0.0;
+    for (const SBObject* obj : m_objects)
+    {
+        totalMass += obj->m_mass;
+    }
+
+    Vec3 center;
+    m_weights.reserve(m_objects.size());
+    for (const SBObject* obj : m_objects)
+    {
+        m_weights.push_back(obj->m_mass / totalMass);
+        center += m_weights.back() * obj->m_currPosition;
+    }
+
+    m_restOffsets.reserve(m_objects.size());
+    for (const SBObject* obj : m_objects)
+    {
+        m_restOffsets.push_back(obj->m_currPosition - center);
+    }
+}
+
+void ee::SBShapeMatchConstraint::satisfyConstraint()
+{
+    // current center of mass:
+    Vec3 center;
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        center += m_weights[i] * m_objects[i]->m_currPosition;
+    }
+
+    // moment matrix Apq = sum(m * p * q^T):
+    glm::tmat3x3<Float> moment(0.0);
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        const Vec3 p = m_weights[i] * (m_objects[i]->m_currPosition - center);
+        const Vec3& q = m_restOffsets[i];
+        moment[0] += p * q.x;
+        moment[1] += p * q.y;
+        moment[2] += p * q.z;
+    }
+
+    extractRotation(moment);
+    const glm::tmat3x3<Float> rotation = glm::mat3_cast(m_rotation);
+
+    // move towards the goal positions:
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        SBObject* const obj = m_objects[i];
+        if (obj->m_type == SBObjectType::ACTIVE)
+        {
+            const Vec3 goal = rotation * m_restOffsets[i] + center;
+            obj->m_currPosition += m_stiffness * (goal - obj->m_currPosition);
+        }
+    }
+}
+
+void ee::SBShapeMatchConstraint::extractRotation(const glm::tmat3x3<Float>& moment)
+{
+    for (int iter = 0; iter < MAX_ROTATION_ITERATIONS; iter++)
+    {
+        const glm::tmat3x3<Float> rot = glm::mat3_cast(m_rotation);
+        const Vec3 omega = (glm::cross(rot[0], moment[0]) + glm::cross(rot[1], moment[1]) + glm::cross(rot[2], moment[2])) *
+            (1.0 / (std::abs(glm::dot(rot[0], moment[0]) + glm::dot(rot[1], moment[1]) + glm::dot(rot[2], moment[2])) + ROTATION_EPS));
+
+        const Float angle = glm::length(omega);
+        if (angle < ROTATION_EPS)
+        {
+            break;
+        }
+
+        m_rotation = glm::normalize(glm::angleAxis(angle, omega / angle) * m_rotation);
+    }
+}
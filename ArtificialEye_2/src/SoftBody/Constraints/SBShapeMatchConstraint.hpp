@@ -0,0 +1,39 @@
+#pragma once
+
+#include "SBConstraint.hpp"
+#include "../../Types.hpp"
+#include "../Objects/SBObject.hpp"
+
+#include <vector>
+#include <glm/mat3x3.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace ee
+{
+    // Region based shape matching (Muller et al. 2005). The objects of the region are pulled towards
+    // their rest shape, rotated and translated to best fit the current positions. The rotation is
+    // extracted from the moment matrix with the iterative method of Muller et al. 2016, warm started
+    // from the rotation of the previous call, so it costs a single polar decomposition per region.
+    class SBShapeMatchConstraint : public SBConstraint
+    {
+    public:
+        // the rest shape is taken from the current positions of the objects
+        SBShapeMatchConstraint(std::vector<SBObject*> objects, Float stiffness);
+
+        void satisfyConstraint() override;
+        SBConstraint* getCopy() const override { return new SBShapeMatchConstraint(*this); }
+
+        std::size_t getNumObjects() const { return m_objects.size(); }
+
+    public:
+        Float m_stiffness;
+
+    private:
+        void extractRotation(const glm::tmat3x3<Float>& moment);
+
+        std::vector<SBObject*>  m_objects;
+        std::vector<Vec3>       m_restOffsets; // rest positions relative to the rest center of mass
+        std::vector<Float>      m_weights;     // normalized masses
+        glm::tquat<Float>       m_rotation;
+    };
+}
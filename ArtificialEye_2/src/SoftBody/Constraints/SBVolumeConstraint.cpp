@@ -0,0 +1,78 @@
+#include "SBVolumeConstraint.hpp"
+
+#include <algorithm>
+#include <glm/gtx/norm.hpp>
+
+ee::SBVolumeConstraint::SBVolumeConstraint(const Mesh* const mesh, std::vector<SBObject*> objects, const Float stiffness) :
+    m_stiffness(stiffness),
+    m_faces(mesh->getMeshFaceData()),
+    m_objects(std::move(objects)),
+    m_gradients(m_objects.size())
+{
+    m_restVolume = calcVolume();
+}
+
+ee::Float ee::SBVolumeConstraint::calcVolume() const
+{
+    // signed, so the winding of the mesh doesn't matter as long as it is consistent
+    Float total = 0.0;
+    for (const MeshFace& f : m_faces)
+    {
+        total += glm::dot(m_objects[f(0)]->m_currPosition,
+            glm::cross(m_objects[f(1)]->m_currPosition, m_objects[f(2)]->m_currPosition)) / 6.0;
+    }
+    return total;
+}
+
+void ee::SBVolumeConstraint::satisfyConstraint()
+{
+    // volume and its gradient in one pass over the faces:
+    std::fill(m_gradients.begin(), m_gradients.end(), Vec3());
+
+    Float volume = 0.0;
+    for (const MeshFace& f : m_faces)
+    {
+        const Vec3& p0 = m_objects[f(0)]->m_currPosition;
+        const Vec3& p1 = m_objects[f(1)]->m_currPosition;
+        const Vec3& p2 = m_objects[f(2)]->m_currPosition;
+
+        const Vec3 c12 = glm::cross(p1, p2);
+        volume += glm::dot(p0, c12);
+
+        m_gradients[f(0)] += c12;
+        m_gradients[f(1)] += glm::cross(p2, p0);
+        m_gradients[f(2)] += glm::cross(p0, p1);
+    }
+    volume /= 6.0;
+
+    const Float error = volume - m_restVolume;
+    if (error == 0.0)
+    {
+        return;
+    }
+
+    // lambda = -C / sum(w * |grad|^2), passive objects have an infinite mass:
+    Float denom = 0.0;
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        if (m_objects[i]->m_type == SBObjectType::ACTIVE)
+        {
+            m_gradients[i] /= 6.0;
+            denom += glm::length2(m_gradients[i]) / m_objects[i]->m_mass;
+        }
+    }
+
+    if (denom < glm::epsilon<Float>())
+    {
+        return;
+    }
+
+    const Float lambda = -m_stiffness * error / denom;
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        if (m_objects[i]->m_type == SBObjectType::ACTIVE)
+        {
+            m_objects[i]->m_currPosition += (lambda / m_objects[i]->m_mass) * m_gradients[i];
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SBConstraint.hpp"
+#include "../../Types.hpp"
+#include "../Objects/SBObject.hpp"
+#include "../../Rendering/Modeling/Mesh.hpp"
+
+#include <vector>
+
+namespace ee
+{
+    // Keeps the volume of a closed mesh at its rest volume. The constraint is projected along the
+    // gradient of the signed volume (see Mesh::calcVolume) with respect to every vertex, which takes
+    // a single pass over the faces. The positions are read from the objects (not the mesh), since the
+    // mesh is only updated once the constraints were satisfied.
+    class SBVolumeConstraint : public SBConstraint
+    {
+    public:
+        // objects[i] is the object of vertex i of the mesh, the rest volume is the current volume
+        SBVolumeConstraint(const Mesh* mesh, std::vector<SBObject*> objects, Float stiffness = 1.0);
+
+        void satisfyConstraint() override;
+        SBConstraint* getCopy() const override { return new SBVolumeConstraint(*this); }
+
+        Float calcVolume() const;
+
+    public:
+        Float m_restVolume;
+        Float m_stiffness;
+
+    private:
+        std::vector<MeshFace>   m_faces;
+        std::vector<SBObject*>  m_objects;
+        std::vector<Vec3>       m_gradients;
+    };
+}
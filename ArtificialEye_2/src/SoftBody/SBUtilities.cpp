@@ -1,5 +1,22 @@
 #include "SBUtilities.hpp"
 
+#include <cmath>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    // the mirrored positions are compared after rounding to this
+    const ee::Float MIRROR_QUANTIZATION = 1.0e-7;
+    const ee::Float AXIS_EPS            = 1.0e-9;
+
+    std::tuple<long long, long long, long long> quantize(const ee::Vec3& pos)
+    {
+        return std::make_tuple(std::llround(pos.x / MIRROR_QUANTIZATION), std::llround(pos.y / MIRROR_QUANTIZATION),
+            std::llround(pos.z / MIRROR_QUANTIZATION));
+    }
+}
+
 void ee::addInteriorSpringsUVSphere(SBClosedBodySim* const sim, const unsigned nLat, const unsigned nLon, const Float stiffness, const Float dampening)
 {
     // This is important, this is only gauranteed to work flawlessly with UV spheres, any other closed body sim is not gauranteed to work.
@@ -22,4 +39,116 @@ void ee::addInteriorSpringsUVSphere(SBClosedBodySim* const sim, const unsigned n
             sim->addConstraint(new SBLengthConstraint(length, sim->getVertexObject(index0), sim->getVertexObject(index1), 0.9));
         }
     }
+}
+
+std::size_t ee::addInteriorSpringsMirrored(SBClosedBodySim* const sim, const Float stiffness, const Float dampening)
+{
+    std::map<std::tuple<long long, long long, long long>, std::size_t> vertices;
+    for (std::size_t i = 0; i < sim->getNumVertexObjects(); i++)
+    {
+        vertices[quantize(sim->getVertexObject(i)->m_currPosition)] = i;
+    }
+
+    std::size_t numSprings = 0;
+    for (std::size_t i = 0; i < sim->getNumVertexObjects(); i++)
+    {
+        SBObject* const obj0 = sim->getVertexObject(i);
+        const Vec3 pos = obj0->m_currPosition;
+        if (pos.y <= 0.0)
+        {
+            continue; // every pair once, the vertices on the equator don't have a partner
+        }
+
+        const auto mirror = vertices.find(quantize(Vec3(pos.x, -pos.y, pos.z)));
+        if (mirror == vertices.end())
+        {
+            continue;
+        }
+
+        SBObject* const obj1 = sim->getVertexObject(mirror->second);
+        sim->addSpring(stiffness, dampening, obj0, obj1);
+
+        // like the caps of the UV sphere, a pair on the axis only gets a spring:
+        if (std::abs(pos.x) > AXIS_EPS || std::abs(pos.z) > AXIS_EPS)
+        {
+            const Float length = glm::length(obj0->m_currPosition - obj1->m_currPosition);
+            sim->addConstraint(&SBLengthConstraint(length, obj0, obj1, 0.9));
+        }
+        numSprings++;
+    }
+
+    return numSprings;
+}
+
+std::size_t ee::addInteriorShapeMatchingUVSphere(SBClosedBodySim* const sim, const unsigned nLat, const unsigned nLon, const Float stiffness, unsigned radius)
+{
+    // Same layout assumptions as above: vertex 0 and the last vertex are the poles, the rings are in between.
+    radius = glm::max(radius, 1u);
+    const std::size_t southPole = sim->getNumVertexObjects() - 1;
+    const unsigned halfLat = (nLat + 1) / 2; // includes the equator ring if there is one
+    const bool fullRings = 2 * radius + 1 >= nLon;
+
+    // adds the vertex of the ring and its mirror image across the equator:
+    auto addMirrored = [sim, nLat, nLon](std::vector<SBObject*>* const o_objects, const unsigned ring, const std::size_t lon)
+    {
+        const unsigned mirror = nLat - 1 - ring;
+        o_objects->push_back(sim->getVertexObject(1 + lon + ring * nLon));
+        if (mirror != ring)
+        {
+            o_objects->push_back(sim->getVertexObject(1 + lon + mirror * nLon));
+        }
+    };
+
+    // the poles are a region of their own, with the first radius rings:
+    std::vector<SBObject*> objects;
+    objects.push_back(sim->getVertexObject(0));
+    objects.push_back(sim->getVertexObject(southPole));
+    for (unsigned ring = 0; ring < glm::min(radius, halfLat); ring++)
+    {
+        for (std::size_t lon = 0; lon < nLon; lon++)
+        {
+            addMirrored(&objects, ring, lon);
+        }
+    }
+    sim->addConstraint(&SBShapeMatchConstraint(std::move(objects), stiffness));
+    std::size_t numRegions = 1;
+
+    // every other vertex of the upper half is the center of a region with the vertices up to radius rings and
+    // meridians away (and the poles, if they are close enough):
+    for (unsigned center = 0; center < halfLat; center++)
+    {
+        const unsigned firstRing = center > radius ? center - radius : 0;
+        const unsigned lastRing = glm::min(center + radius, halfLat - 1);
+        for (std::size_t centerLon = 0; centerLon < nLon; centerLon++)
+        {
+            objects.clear();
+            if (center + 1 <= radius)
+            {
+                objects.push_back(sim->getVertexObject(0));
+                objects.push_back(sim->getVertexObject(southPole));
+            }
+
+            for (unsigned ring = firstRing; ring <= lastRing; ring++)
+            {
+                if (fullRings)
+                {
+                    for (std::size_t lon = 0; lon < nLon; lon++)
+                    {
+                        addMirrored(&objects, ring, lon);
+                    }
+                    continue;
+                }
+
+                for (std::size_t offset = 0; offset <= 2 * radius; offset++)
+                {
+                    addMirrored(&objects, ring, (centerLon + nLon + offset - radius) % nLon);
+                }
+            }
+
+            sim->addConstraint(&SBShapeMatchConstraint(std::move(objects), stiffness));
+            numRegions++;
+        }
+    }
+
+    return numRegions;
 }
\ No newline at end of file
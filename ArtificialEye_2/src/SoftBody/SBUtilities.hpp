@@ -2,8 +2,18 @@
 
 #include "Simulation/SBClosedBodySim.hpp"
 #include "Constraints/SBLengthConstraint.hpp"
+#include "Constraints/SBShapeMatchConstraint.hpp"
 
 namespace ee
 {
     void addInteriorSpringsUVSphere(SBClosedBodySim* sim, unsigned nLat, unsigned nLon, Float stiffness, Float dampening);
+
+    // Same as addInteriorSpringsUVSphere for any sphere that is symmetric about its equator (like an icosphere):
+    // every vertex is connected to its mirror image across the y = 0 plane. Returns the number of springs.
+    std::size_t addInteriorSpringsMirrored(SBClosedBodySim* sim, Float stiffness, Float dampening);
+
+    // Alternative to the interior springs: overlapping local regions, one around every vertex of the upper half
+    // with the vertices up to radius rings and meridians away, together with their mirror images (so the
+    // thickness of the lens is kept), and one around the poles. Returns the number of regions that were added.
+    std::size_t addInteriorShapeMatchingUVSphere(SBClosedBodySim* sim, unsigned nLat, unsigned nLon, Float stiffness, unsigned radius);
 }
\ No newline at end of file
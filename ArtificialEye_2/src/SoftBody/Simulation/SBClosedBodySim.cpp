@@ -4,7 +4,6 @@ ee::SBClosedBodySim::SBClosedBodySim(Float P, Mesh* model, Float mass, Float sti
     SBMeshBasedSim(model, mass, stiffness, dampening),
     m_pressure(addLocalForceGen(&SBPressure(P, model, this)))
 {
-    addLocalForceGen(&SBPressure(P, model, this));
 }
 
 void ee::SBClosedBodySim::setP(Float P)
@@ -12,6 +11,23 @@ void ee::SBClosedBodySim::setP(Float P)
     m_pressure->m_P = P;
 }
 
+ee::Float ee::SBClosedBodySim::getP() const
+{
+    return m_pressure->m_P;
+}
+
+ee::SBVolumeConstraint* ee::SBClosedBodySim::addVolumeConstraint(const Float stiffness)
+{
+    std::vector<SBObject*> objects;
+    objects.reserve(getNumVertexObjects());
+    for (std::size_t i = 0; i < getNumVertexObjects(); i++)
+    {
+        objects.push_back(getVertexObject(i));
+    }
+
+    return addConstraint(&SBVolumeConstraint(m_model, std::move(objects), stiffness));
+}
+
 ee::SBClosedBodySim::SBPressure::SBPressure(Float P, Mesh* model, SBMeshBasedSim* simulation) :
     m_model(model),
     m_simulation(simulation),
@@ -2,6 +2,7 @@
 
 #include "SBMeshBasedSim.hpp"
 #include "../../SoftBody/ForceGens/SBLocalForceGen.hpp"
+#include "../Constraints/SBVolumeConstraint.hpp"
 
 namespace ee
 {
@@ -11,6 +12,11 @@ namespace ee
         SBClosedBodySim(Float P, Mesh* model, Float mass, Float stiffness, Float dampening);
 
         void setP(Float P);
+        Float getP() const;
+
+        // Keeps the volume at the current volume with a constraint instead of (or on top of) the pressure force.
+        // The constraint doesn't limit the time step like a stiff pressure does.
+        SBVolumeConstraint* addVolumeConstraint(Float stiffness = 1.0);
 
     private:
         friend class SBPressure;
@@ -19,16 +19,23 @@ void ee::SBMeshBasedSim::update(Float timeStep)
 
 void ee::SBMeshBasedSim::addCustomLengthConstraint(Float length, std::size_t vertexID0, std::size_t vertexID1)
 {
-    SBSimulation::addConstraint(new SBLengthConstraint(length, m_objects[vertexID0].get(), m_objects[vertexID1].get()));
+    SBSimulation::addConstraint(new SBLengthConstraint(length, getVertexObject(vertexID0), getVertexObject(vertexID1)));
+}
+
+const ee::Mesh* ee::SBMeshBasedSim::getMesh() const
+{
+    return m_model;
 }
 
 void ee::SBMeshBasedSim::createSimVertices(Float mass)
 {
+    const std::size_t start = m_objects.size();
     Float vertexMass = mass / m_model->getNumVertices();
     for (std::size_t i = 0; i < m_model->getNumVertices(); i++)
     {
         SBSimulation::addObject(&SBVertex(vertexMass, SBObjectType::ACTIVE, m_model, i));
     }
+    bindVertexObjects(start, m_model->getNumVertices());
 }
 
 void ee::SBMeshBasedSim::connectSprings(Float structStiffness, Float structDampening)
@@ -42,13 +49,16 @@ void ee::SBMeshBasedSim::connectSprings(Float structStiffness, Float structDampe
             continue; // if we have two that are the same, this could lead to some major issues
         }
 
-        Float zValue = (m_objects[index0]->m_currPosition.y + m_objects[index1]->m_currPosition.y) * 0.5f;
+        SBObject* const obj0 = getVertexObject(index0);
+        SBObject* const obj1 = getVertexObject(index1);
+
+        Float zValue = (obj0->m_currPosition.y + obj1->m_currPosition.y) * 0.5f;
         Float mult = 1 - std::abs(zValue);
         
         const Float stiffness = mult * structStiffness; // so this number decreases as the area of the face increases
 
-        SBSimulation::addSpring(stiffness, structDampening, m_objects[index0].get(), m_objects[index1].get());
-        Float length = glm::length(m_objects[index0]->m_currPosition - m_objects[index1]->m_currPosition);
-        SBSimulation::addConstraint(new SBLengthConstraint(length, m_objects[index0].get(), m_objects[index1].get()));
+        SBSimulation::addSpring(stiffness, structDampening, obj0, obj1);
+        Float length = glm::length(obj0->m_currPosition - obj1->m_currPosition);
+        SBSimulation::addConstraint(new SBLengthConstraint(length, obj0, obj1));
     }
 }
\ No newline at end of file
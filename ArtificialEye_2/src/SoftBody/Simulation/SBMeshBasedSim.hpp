@@ -17,6 +17,8 @@ namespace ee
 
         void addCustomLengthConstraint(Float length, std::size_t vertexID0, std::size_t vertexID1);
 
+        const Mesh* getMesh() const;
+
     protected:
         Mesh* m_model;
 
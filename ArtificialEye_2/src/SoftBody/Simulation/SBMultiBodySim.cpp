@@ -0,0 +1,174 @@
+#include "SBMultiBodySim.hpp"
+
+#include "../../Parallel.hpp"
+
+#include <stdexcept>
+
+ee::SBMultiBodySim::SBMultiBodySim() :
+    m_constIterations(1),
+    m_islandsDirty(true)
+{
+}
+
+std::size_t ee::SBMultiBodySim::addBody(SBSimulation* const body)
+{
+    if (body == nullptr)
+    {
+        throw std::logic_error("Can't add a null body to the multi body simulation.");
+    }
+
+    SBBody newBody;
+    newBody.m_sim = body;
+    newBody.m_begin = m_bodies.empty() ? 0 : m_bodies.back().m_end;
+    newBody.m_end = newBody.m_begin + body->getNumVertexObjects();
+    m_bodies.push_back(newBody);
+
+    m_islandsDirty = true;
+    return m_bodies.size() - 1;
+}
+
+void ee::SBMultiBodySim::update(const Float timeStep)
+{
+    if (m_islandsDirty)
+    {
+        buildIslands();
+    }
+
+    // islands don't share any objects, so they can be stepped independently:
+    parallelFor(0, m_islands.size(), [this, timeStep](std::size_t islandID)
+    {
+        SBIsland& island = m_islands[islandID];
+        for (std::size_t bodyID : island.m_bodies)
+        {
+            m_bodies[bodyID].m_sim->update(timeStep);
+        }
+
+        if (island.m_couplingConstraints.empty())
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < m_constIterations; i++)
+        {
+            for (SBConstraint* constraint : island.m_couplingConstraints)
+            {
+                constraint->satisfyConstraint();
+            }
+        }
+
+        // the coupling moved some of the objects after the bodies were updated:
+        for (std::size_t bodyID : island.m_bodies)
+        {
+            m_bodies[bodyID].m_sim->updateObjects(timeStep);
+        }
+    });
+}
+
+ee::SBSimulation* ee::SBMultiBodySim::getBody(const std::size_t bodyID)
+{
+    return m_bodies[bodyID].m_sim;
+}
+
+const ee::SBSimulation* ee::SBMultiBodySim::getBody(const std::size_t bodyID) const
+{
+    return m_bodies[bodyID].m_sim;
+}
+
+std::size_t ee::SBMultiBodySim::getNumBodies() const
+{
+    return m_bodies.size();
+}
+
+std::size_t ee::SBMultiBodySim::getNumIslands()
+{
+    if (m_islandsDirty)
+    {
+        buildIslands();
+    }
+    return m_islands.size();
+}
+
+std::size_t ee::SBMultiBodySim::getBodyBegin(const std::size_t bodyID) const
+{
+    return m_bodies[bodyID].m_begin;
+}
+
+std::size_t ee::SBMultiBodySim::getBodyEnd(const std::size_t bodyID) const
+{
+    return m_bodies[bodyID].m_end;
+}
+
+ee::SBObject* ee::SBMultiBodySim::getVertexObject(const std::size_t bodyID, const std::size_t vertexID)
+{
+    return m_bodies[bodyID].m_sim->getVertexObject(vertexID);
+}
+
+ee::SBObject* ee::SBMultiBodySim::getObject(const std::size_t globalIndex)
+{
+    for (const SBBody& body : m_bodies)
+    {
+        if (globalIndex < body.m_end)
+        {
+            return body.m_sim->getVertexObject(globalIndex - body.m_begin);
+        }
+    }
+
+    throw std::out_of_range("Global object index is out of the range of all bodies.");
+}
+
+std::size_t ee::SBMultiBodySim::getNumObjects() const
+{
+    return m_bodies.empty() ? 0 : m_bodies.back().m_end;
+}
+
+void ee::SBMultiBodySim::buildIslands()
+{
+    // union-find over the bodies, joined by the coupling constraints:
+    std::vector<std::size_t> parents(m_bodies.size());
+    for (std::size_t i = 0; i < parents.size(); i++)
+    {
+        parents[i] = i;
+    }
+
+    auto findRoot = [&parents](std::size_t i)
+    {
+        while (parents[i] != i)
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    };
+
+    for (const auto& coupled : m_couplingBodies)
+    {
+        const std::size_t rootA = findRoot(coupled.first);
+        const std::size_t rootB = findRoot(coupled.second);
+        if (rootA != rootB)
+        {
+            parents[rootB] = rootA;
+        }
+    }
+
+    // assign each root an island:
+    m_islands.clear();
+    std::vector<std::size_t> islandOfRoot(m_bodies.size(), m_bodies.size());
+    for (std::size_t i = 0; i < m_bodies.size(); i++)
+    {
+        const std::size_t root = findRoot(i);
+        if (islandOfRoot[root] == m_bodies.size())
+        {
+            islandOfRoot[root] = m_islands.size();
+            m_islands.push_back(SBIsland());
+        }
+        m_islands[islandOfRoot[root]].m_bodies.push_back(i);
+    }
+
+    for (std::size_t i = 0; i < m_couplingConstraints.size(); i++)
+    {
+        const std::size_t island = islandOfRoot[findRoot(m_couplingBodies[i].first)];
+        m_islands[island].m_couplingConstraints.push_back(m_couplingConstraints[i].get());
+    }
+
+    m_islandsDirty = false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "SBSimulation.hpp"
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+namespace ee
+{
+    // Steps several soft bodies (lens, cornea, a second eye, ...) together. Every body keeps its own
+    // mesh binding (see SBMeshBasedSim::getMesh) and owns a contiguous range of the global object
+    // indices. Bodies that are not coupled by constraints form their own island, and islands are
+    // stepped in parallel.
+    class SBMultiBodySim
+    {
+    public:
+        SBMultiBodySim();
+
+        // The body is not managed by the simulation (and should be fully set up before being added).
+        // Returns the ID of the body.
+        std::size_t addBody(SBSimulation* body);
+
+        // Adds a constraint between objects of two bodies, those bodies will be stepped in the same island.
+        template<typename T>
+        T* addCouplingConstraint(T* constraint, std::size_t bodyA, std::size_t bodyB);
+
+        void update(Float timeStep);
+
+        SBSimulation*       getBody(std::size_t bodyID);
+        const SBSimulation* getBody(std::size_t bodyID) const;
+        std::size_t         getNumBodies() const;
+        std::size_t         getNumIslands();
+
+        // global index range [begin, end) of a body's vertex objects:
+        std::size_t getBodyBegin(std::size_t bodyID) const;
+        std::size_t getBodyEnd(std::size_t bodyID) const;
+
+        SBObject* getVertexObject(std::size_t bodyID, std::size_t vertexID);
+        SBObject* getObject(std::size_t globalIndex);
+        std::size_t getNumObjects() const;
+
+    public:
+        // iterations used for the coupling constraints between bodies
+        std::size_t m_constIterations;
+
+    private:
+        struct SBBody
+        {
+            SBSimulation*   m_sim;
+            std::size_t     m_begin;
+            std::size_t     m_end;
+        };
+
+        struct SBIsland
+        {
+            std::vector<std::size_t>    m_bodies;
+            std::vector<SBConstraint*>  m_couplingConstraints;
+        };
+
+        void buildIslands();
+
+        std::vector<SBBody>                             m_bodies;
+        std::vector<SBIsland>                           m_islands;
+        bool                                            m_islandsDirty;
+
+        SBConstraintList                                m_couplingConstraints;
+        std::vector<std::pair<std::size_t, std::size_t>> m_couplingBodies;
+    };
+}
+
+#include "SBMultiBodySim.inl"
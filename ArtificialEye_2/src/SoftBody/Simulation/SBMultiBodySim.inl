@@ -0,0 +1,11 @@
+
+template<typename T>
+T* ee::SBMultiBodySim::addCouplingConstraint(T* constraint, std::size_t bodyA, std::size_t bodyB)
+{
+    T* ptr = new T(*constraint);
+    std::unique_ptr<SBConstraint> smartPtr(ptr);
+    m_couplingConstraints.push_back(std::move(smartPtr));
+    m_couplingBodies.push_back(std::make_pair(bodyA, bodyB));
+    m_islandsDirty = true;
+    return ptr;
+}
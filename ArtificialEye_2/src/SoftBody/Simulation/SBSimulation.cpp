@@ -1,5 +1,13 @@
 #include "SBSimulation.hpp"
 
+ee::SBSimulation::SBSimulation() :
+    m_constIterations(1),
+    m_vertexObjectsBound(false),
+    m_vertexObjectStart(0),
+    m_numVertexObjects(0)
+{
+}
+
 void ee::SBSimulation::addSpring(const Float stiffness, const Float dampening, SBObject* const objA, SBObject* const objB)
 {
     m_springs.push_back(std::unique_ptr<SBSpring>(
@@ -80,10 +88,7 @@ void ee::SBSimulation::update(Float timeStep)
     }
 
     // update the object's position:
-    for (auto& object : m_objects)
-    {
-        object->update(timeStep);
-    }
+    updateObjects(timeStep);
 
     // reset them forces:
     for (auto& object : m_objects)
@@ -95,17 +100,37 @@ void ee::SBSimulation::update(Float timeStep)
     }
 }
 
+void ee::SBSimulation::updateObjects(const Float timeStep)
+{
+    for (auto& object : m_objects)
+    {
+        object->update(timeStep);
+    }
+}
+
 ee::SBObject* ee::SBSimulation::getVertexObject(const std::size_t vertexID)
 {
-    return m_objects[vertexID].get();
+    return m_objects[m_vertexObjectStart + vertexID].get();
 }
 
 const ee::SBObject* ee::SBSimulation::getVertexObject(const std::size_t vertexID) const
 {
-    return getVertexObject(vertexID);
+    return m_objects[m_vertexObjectStart + vertexID].get();
 }
 
 std::size_t ee::SBSimulation::getNumVertexObjects() const
+{
+    return m_vertexObjectsBound ? m_numVertexObjects : m_objects.size();
+}
+
+std::size_t ee::SBSimulation::getNumObjects() const
 {
     return m_objects.size();
 }
+
+void ee::SBSimulation::bindVertexObjects(const std::size_t start, const std::size_t count)
+{
+    m_vertexObjectsBound = true;
+    m_vertexObjectStart = start;
+    m_numVertexObjects = count;
+}
@@ -23,6 +23,8 @@ namespace ee
     class SBSimulation
     {
     public:
+        SBSimulation();
+
         void addSpring(Float stiffness, Float dampening, SBObject* objA, SBObject* objB);
         void addSpring(Float stiffness, Float dampening, Float length, SBObject* objA, SBObject* objB);
         SBObject* addObject(SBObject* obj);
@@ -38,15 +40,23 @@ namespace ee
 
         virtual void update(Float timeStep);
 
+        // pushes the current positions of the objects (e.g. to the mesh they are bound to)
+        void updateObjects(Float timeStep);
+
+        // vertex objects are indexed relative to the range that was bound to the mesh,
+        // so other objects can be added to the simulation before or after them
         SBObject* getVertexObject(std::size_t VertexID);
         const SBObject* getVertexObject(std::size_t VertexID) const;
 
         std::size_t getNumVertexObjects() const;
+        std::size_t getNumObjects() const;
 
     public:
         std::size_t                     m_constIterations;
 
     protected:
+        void bindVertexObjects(std::size_t start, std::size_t count);
+
         SBObjectList                    m_objects;
         SBGlobalForceGenList            m_globalForceGens;
         SBLocalForceGenList             m_localForceGens;
@@ -54,6 +64,11 @@ namespace ee
         std::unique_ptr<SBIntegrator>   m_integrator;
 
         SBConstraintList                m_constraints;
+
+    private:
+        bool                            m_vertexObjectsBound;
+        std::size_t                     m_vertexObjectStart;
+        std::size_t                     m_numVertexObjects;
     };
 }
 
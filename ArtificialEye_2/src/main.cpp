@@ -9,22 +9,32 @@
 #include "Rendering/TexturePacks/RefractTextPack.hpp"
 #include "Rendering/TexturePacks/LineUniColorTextPack.hpp"
 #include "RayTracing/RayTracer.hpp"
+#include "RayTracing/SpotDiagram.hpp"
+#include "RayTracing/MTF.hpp"
+#include "RayTracing/ParaxialEstimator.hpp"
 #include "Rendering/Lens.hpp"
 #include "SoftBody/Simulation/SBClosedBodySim.hpp"
+#include "SoftBody/Simulation/SBMultiBodySim.hpp"
 #include "SoftBody/ForceGens/SBGravity.hpp"
 #include "SoftBody/Constraints/SBPointConstraint.hpp"
 #include "SoftBody/Integrators/SBVerletIntegrator.hpp"
 #include "SoftBody/Objects/SBFixedPoint.hpp"
 #include "SoftBody/SBUtilities.hpp"
 #include "Rendering/Subdivision.hpp"
+#include "Rendering/SubdivisionStencil.hpp"
+#include "Rendering/AdaptiveSubdivision.hpp"
+#include "Rendering/LimitSurface.hpp"
 #include "Rendering/Modeling/DrawableMeshContainer.hpp"
 #include "Rendering/Modeling/LoadableModel.hpp"
+#include "Recording/TrajectoryRecorder.hpp"
 
 #include "Alglib/interpolation.h"
 
 #include <string>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <algorithm>
 
 using namespace ee;
 
@@ -48,6 +58,7 @@ std::vector<ee::SBPointConstraint*> g_constraints;
 const Float g_constraintMoveSpeed = 0.1;
 ee::RayTracer* g_tracer;
 bool g_defaultP = true;
+bool g_printRetinaImage = false;
 
 void addConstraints(const std::size_t thickness, ee::SBSimulation* sim, const ee::Mesh* mesh)
 {
@@ -64,6 +75,55 @@ void addConstraints(const std::size_t thickness, ee::SBSimulation* sim, const ee
     }
 }
 
+// the image of the pupil on the retina, kept between lens updates so the rays, bins and FFT plan are reused
+struct RetinaImage
+{
+    std::vector<Ray> m_pupilRays;
+    std::vector<Ray> m_exitRays;
+    SpotDiagram      m_spots;
+    MTF              m_mtf;
+
+    RetinaImage() :
+        m_pupilRays(makePupilRays(Vec3(0.0, 0.0, -2.0), Vec3(0.0, 0.0, 1.0), ARTIFICIAL_EYE_PROP.pupil_radius, ARTIFICIAL_EYE_PROP.spot_rays)),
+        m_spots(ARTIFICIAL_EYE_PROP.psf_resolution, ARTIFICIAL_EYE_PROP.psf_half_width),
+        m_mtf(ARTIFICIAL_EYE_PROP.psf_resolution) {}
+};
+
+void analyzeRetinaImage(ee::RayTracer* tracer, RetinaImage* image)
+{
+    tracer->traceBundle(image->m_pupilRays, &image->m_exitRays);
+    image->m_spots.compute(image->m_exitRays, ARTIFICIAL_EYE_PROP.retina_z);
+    image->m_mtf.compute(image->m_spots.getPSF(), image->m_spots.getPixelSize());
+}
+
+void printRetinaImage(const RetinaImage& image)
+{
+    const SpotDiagram& spots = image.m_spots;
+    const MTF& mtf = image.m_mtf;
+    const std::vector<Float>& psf = spots.getPSF();
+    std::cout << "[SPOT DIAGRAM]: " << spots.getNumSpots() << " of " << image.m_pupilRays.size() << " rays reached the retina" << std::endl;
+    std::cout << "centroid:   (" << spots.getCentroid().x << ", " << spots.getCentroid().y << ")" << std::endl;
+    std::cout << "RMS radius: " << spots.getRMSRadius() << ", max radius: " << spots.getMaxRadius() << std::endl;
+    std::cout << "EE50: " << spots.calcEncircledRadius(0.5) << ", EE80: " << spots.calcEncircledRadius(0.8) << std::endl;
+    std::cout << "PSF peak:   " << (psf.empty() ? 0.0 : *std::max_element(psf.begin(), psf.end())) << std::endl;
+    std::cout << "MTF50 (radial, tangential, sagittal): " << mtf.calcFrequency(mtf.getRadialMTF(), 0.5) << ", "
+        << mtf.calcFrequency(mtf.getTangentialMTF(), 0.5) << ", " << mtf.calcFrequency(mtf.getSagittalMTF(), 0.5) << std::endl;
+}
+
+void printParaxial(const ParaxialEstimator& paraxial)
+{
+    if (!paraxial.isValid())
+    {
+        std::cout << "[PARAXIAL]: only " << paraxial.getNumCrossings() << " rays of the fan crossed the axis" << std::endl;
+        return;
+    }
+
+    std::cout << "[PARAXIAL]: back focus at z = " << paraxial.getBackFocus() << ", focal length: " << paraxial.getFocalLength() << std::endl;
+    std::cout << "power: " << paraxial.getPower() * 1000.0 / ARTIFICIAL_EYE_PROP.mm_per_unit << " D" << std::endl;
+    std::cout << "spherical aberration: " << paraxial.getSphericalAberration()[0] << " h^2 + " << paraxial.getSphericalAberration()[1]
+        << " h^4, longitudinal: " << paraxial.getLongitudinalAberration() << std::endl;
+}
+
 void setSpaceCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (key == GLFW_KEY_SPACE)
@@ -87,6 +147,13 @@ void setSpaceCallback(GLFWwindow* window, int key, int scancode, int action, int
             g_defaultP = !g_defaultP;
         }
     }
+    else if (key == GLFW_KEY_P)
+    {
+        if (action == GLFW_PRESS)
+        {
+            g_printRetinaImage = true;
+        }
+    }
 
     if (action == GLFW_PRESS && (key == GLFW_KEY_UP || key == GLFW_KEY_DOWN))
     {
@@ -139,8 +206,14 @@ int main()
         mat = glm::scale(mat, Vec3(1.55f, 1.55f, 1.55f));
         eyeballModel.setTransform(mat);
 
-        // generate the UV Sphere lens (not super efficient)
-        Mesh uvSphereMesh = loadUVsphere(ARTIFICIAL_EYE_PROP.longitude, ARTIFICIAL_EYE_PROP.latitude);
+        // generate the lens, a UV sphere or an icosphere (not super efficient)
+        const bool icosphereLens = ARTIFICIAL_EYE_PROP.mesh_type == 1;
+        if (icosphereLens && ARTIFICIAL_EYE_PROP.interior_model == 1)
+        {
+            throw std::runtime_error("Shape matching needs a UV sphere lens (mesh_type=0).");
+        }
+        Mesh uvSphereMesh = icosphereLens ? loadIcosphere(ARTIFICIAL_EYE_PROP.icosphere_level) :
+            loadUVsphere(ARTIFICIAL_EYE_PROP.longitude, ARTIFICIAL_EYE_PROP.latitude);
         Mesh uvSubDivSphereMesh = uvSphereMesh; // loopSubdiv(uvSphereMesh, ARTIFICIAL_EYE_PROP.subdiv_level);
         Lens lensSphere(&uvSubDivSphereMesh, ARTIFICIAL_EYE_PROP.latitude, ARTIFICIAL_EYE_PROP.longitude);
         DrawableMeshContainer lensDrawable(&uvSubDivSphereMesh, "refractTextPack", true);
@@ -155,25 +228,77 @@ int main()
         uvSubDivSphereMesh.setModelTrans(lensModelTrans);
 
         // prepare the simulation
-        SBClosedBodySim lensSim(ARTIFICIAL_EYE_PROP.pressure, &uvSphereMesh, ARTIFICIAL_EYE_PROP.mass, ARTIFICIAL_EYE_PROP.extspring_coeff, ARTIFICIAL_EYE_PROP.extspring_drag);
+        // the volume constraint replaces the pressure force:
+        const Float lensPressure = ARTIFICIAL_EYE_PROP.volume_constraint ? 0.0 : ARTIFICIAL_EYE_PROP.pressure;
+        SBClosedBodySim lensSim(lensPressure, &uvSphereMesh, ARTIFICIAL_EYE_PROP.mass, ARTIFICIAL_EYE_PROP.extspring_coeff, ARTIFICIAL_EYE_PROP.extspring_drag);
         lensSim.m_constIterations = ARTIFICIAL_EYE_PROP.iterations;
-        addInteriorSpringsUVSphere(&lensSim, ARTIFICIAL_EYE_PROP.latitude, ARTIFICIAL_EYE_PROP.longitude, ARTIFICIAL_EYE_PROP.intspring_coeff, ARTIFICIAL_EYE_PROP.intspring_drag);
+        if (ARTIFICIAL_EYE_PROP.interior_model == 1)
+        {
+            addInteriorShapeMatchingUVSphere(&lensSim, ARTIFICIAL_EYE_PROP.latitude, ARTIFICIAL_EYE_PROP.longitude, ARTIFICIAL_EYE_PROP.shape_match_stiffness, ARTIFICIAL_EYE_PROP.shape_match_radius);
+        }
+        else if (icosphereLens)
+        {
+            addInteriorSpringsMirrored(&lensSim, ARTIFICIAL_EYE_PROP.intspring_coeff, ARTIFICIAL_EYE_PROP.intspring_drag);
+        }
+        else
+        {
+            addInteriorSpringsUVSphere(&lensSim, ARTIFICIAL_EYE_PROP.latitude, ARTIFICIAL_EYE_PROP.longitude, ARTIFICIAL_EYE_PROP.intspring_coeff, ARTIFICIAL_EYE_PROP.intspring_drag);
+        }
         //addConstraints(5, &lensSim, &lensMesh);
         lensSim.addIntegrator(&ee::SBVerletIntegrator(1.0 / 20.0, ARTIFICIAL_EYE_PROP.extspring_drag));
+        if (ARTIFICIAL_EYE_PROP.volume_constraint)
+        {
+            lensSim.addVolumeConstraint();
+        }
 
         // test stuff:
         const std::vector<Vec3> pos = {Vec3(0.0, 0.0, -2.0)};
         RayTracerParam param;
         param.m_widthResolution = 5;
         param.m_heightResolution = 5;
-        param.m_lensRefractiveIndex = 1.406;
+        param.m_lensRefractiveIndex_middle = 1.406;
+        param.m_lensRefractiveIndex_end = 1.386;
+        param.m_eyeballRefractiveIndex = 1.336;
         param.m_enviRefractiveIndex = 1.0;
         param.m_rayColor = Vec3(1.0, 0.0, 0.0);
         g_constraints = lensSphere.addConstraints(5, &lensSim);
+
+        // every soft body of the eye is stepped through here, bodies that don't interact in parallel:
+        SBMultiBodySim eyeSim;
+        eyeSim.addBody(&lensSim);
         g_tracer = &ee::RayTracer::initialize(pos, lensSphere, param);
+        g_tracer->setGradientIndex(ARTIFICIAL_EYE_PROP.gradient_index);
+
+        std::unique_ptr<TrajectoryRecorder> recorder;
+        if (ARTIFICIAL_EYE_PROP.record_trajectory)
+        {
+            recorder.reset(new TrajectoryRecorder(ARTIFICIAL_EYE_PROP.trajectory_file, uvSphereMesh.getNumVertices(),
+                uvSphereMesh.getMeshFaceData(), g_constraints.size()));
+        }
+        Float simulationTime = 0.0;
+
+        // the lens topology never changes, so the uniform subdivision is a precomputed stencil (the adaptive one
+        // changes with the marks and doesn't need it):
+        const SubdivisionStencil* const lensStencil = ARTIFICIAL_EYE_PROP.adaptive_subdiv ? nullptr :
+            &getSubdivisionStencil(uvSphereMesh, ARTIFICIAL_EYE_PROP.subdiv_level_lens);
+        std::vector<int> lensParentFaces; // control mesh face of every face of the adaptively subdivided lens
+        FaceMarks lensMarks;
+        AdaptiveSubdivWorkspace lensAdaptiveWorkspace;
+
+        std::unique_ptr<LimitSurface> lensLimitSurface;
+        if (ARTIFICIAL_EYE_PROP.limit_surface_optics)
+        {
+            lensLimitSurface.reset(new LimitSurface(&uvSphereMesh));
+            g_tracer->setLimitSurface(lensLimitSurface.get());
+        }
 
         uvSubDivSphereMesh.calcNormals();
         g_tracer->raytrace();
+
+        RetinaImage retinaImage;
+        analyzeRetinaImage(g_tracer, &retinaImage);
+        ParaxialEstimator paraxial(Vec3(0.0, 0.0, -2.0), ARTIFICIAL_EYE_PROP.fan_rays, ARTIFICIAL_EYE_PROP.fan_height, param.m_eyeballRefractiveIndex);
+        paraxial.estimate(g_tracer);
         while (ee::Renderer::isInitialized())
         {
             assert(glGetError() == 0);
@@ -189,7 +314,7 @@ int main()
 
             if (g_defaultP)
             {
-                lensSim.setP(ARTIFICIAL_EYE_PROP.pressure);
+                lensSim.setP(lensPressure);
             }
             else
             {
@@ -201,11 +326,58 @@ int main()
             float time = Renderer::timeElapsed();
             if (g_startSoftBody)
             {
-                lensSim.update(time);
-                Mesh tempMesh = loopSubdiv(uvSphereMesh, ARTIFICIAL_EYE_PROP.subdiv_level_lens);
-                uvSubDivSphereMesh.updateVertices(std::move(tempMesh.getVerticesData()));
-                uvSubDivSphereMesh.updateMeshFaces(std::move(tempMesh.getMeshFaceData()));
+                eyeSim.update(time);
+                simulationTime += time;
+                if (recorder)
+                {
+                    recorder->record(simulationTime, uvSphereMesh, g_constraints, lensSim.getP());
+                }
+
+                if (ARTIFICIAL_EYE_PROP.adaptive_subdiv)
+                {
+                    // only refine around the optical axis, where the curvature is high and where the rays hit last frame:
+                    lensMarks.assign(uvSphereMesh.getNumMeshFaces(), false);
+                    markFacesNearAxis(uvSphereMesh, Ray(Vec3(), Vec3(0.0, 0.0, 1.0)), ARTIFICIAL_EYE_PROP.adaptive_axis_radius, &lensMarks);
+                    if (ARTIFICIAL_EYE_PROP.adaptive_curvature_angle > 0.0)
+                    {
+                        markCurvedFaces(uvSphereMesh, glm::radians(ARTIFICIAL_EYE_PROP.adaptive_curvature_angle), &lensMarks);
+                    }
+                    if (!lensLimitSurface)
+                    {
+                        markParentFaces(g_tracer->getHitFaces(), lensParentFaces, &lensMarks);
+                    }
+
+                    adaptiveLoopSubdiv(uvSphereMesh, lensMarks, ARTIFICIAL_EYE_PROP.subdiv_level_lens, &uvSubDivSphereMesh, &lensParentFaces, &lensAdaptiveWorkspace);
+
+                    // the vertices come from the workspace, so none of their normals are from the last frame:
+                    uvSubDivSphereMesh.calcNormals();
+                }
+                else
+                {
+                    lensStencil->apply(uvSphereMesh.getVerticesData(), &uvSubDivSphereMesh.editVertices());
+                    if (uvSubDivSphereMesh.getNumMeshFaces() != lensStencil->getMeshFaces().size())
+                    {
+                        uvSubDivSphereMesh.updateMeshFaces(lensStencil->getMeshFaces());
+                    }
+                    uvSubDivSphereMesh.calcNormalsIncremental();
+                }
                 g_tracer->raytrace();
+                paraxial.estimate(g_tracer);
+                if (ARTIFICIAL_EYE_PROP.analyze_every_update)
+                {
+                    analyzeRetinaImage(g_tracer, &retinaImage);
+                }
+            }
+
+            if (g_printRetinaImage)
+            {
+                if (!ARTIFICIAL_EYE_PROP.analyze_every_update)
+                {
+                    analyzeRetinaImage(g_tracer, &retinaImage);
+                }
+                printRetinaImage(retinaImage);
+                printParaxial(paraxial);
+                g_printRetinaImage = false;
             }
 
             Renderer::drawAll();
@@ -213,6 +385,12 @@ int main()
             Renderer::swapBuffers();
             Renderer::pollEvents();
         }
+
+        if (recorder)
+        {
+            // so a failed write is reported:
+            recorder->close();
+        }
     }
     catch (const std::exception& e)
     {